@@ -0,0 +1,85 @@
+#!/bin/bash
+# GitSync - fsmonitor benchmark
+# Usage: fsmonitor-bench.sh BINARY WORKDIR [ROUNDS]
+#
+# Builds a large synthetic worktree (created in WORKDIR on first use) and
+# times `git status` after touching a few files, first with a plain full
+# scan and then with gitsync serving core.fsmonitor from watch mode. Prints
+# the best wall time of each over ROUNDS runs. Needs Linux (inotify).
+
+set -e
+
+BIN="$1"
+WORKDIR="$2"
+ROUNDS="${3:-5}"
+
+if [ -z "$BIN" ] || [ -z "$WORKDIR" ]; then
+    echo "Usage: $0 BINARY WORKDIR [ROUNDS]" >&2
+    exit 2
+fi
+
+BIN=$(cd "$(dirname "$BIN")" && pwd)/$(basename "$BIN")
+mkdir -p "$WORKDIR"
+WORKDIR=$(cd "$WORKDIR" && pwd)
+TREE="$WORKDIR/tree"
+REPO="$TREE/large"
+DIRS=200
+FILES_PER_DIR=250
+
+# Keep the user's gitsync cache and git config out of the measurement
+export HOME="$WORKDIR/home"
+mkdir -p "$HOME"
+
+git_quiet() {
+    git -c user.name=gitsync -c user.email=gitsync@localhost -c init.defaultBranch=main "$@" >/dev/null 2>&1
+}
+
+create_repo() {
+    git_quiet init "$REPO"
+    for d in $(seq 1 $DIRS); do
+        mkdir -p "$REPO/pkg$((d % 20))/mod$d"
+        for f in $(seq 1 $FILES_PER_DIR); do
+            echo "$d/$f" > "$REPO/pkg$((d % 20))/mod$d/file$f.txt"
+        done
+    done
+    git_quiet -C "$REPO" add -A
+    git_quiet -C "$REPO" commit -m "initial"
+}
+
+# Best time over ROUNDS of: touch three files, git status
+time_status() {
+    local best=""
+    for i in $(seq 1 "$ROUNDS"); do
+        touch "$REPO/pkg1/mod1/file$i.txt" "$REPO/pkg$(((100 + i) % 20))/mod$((100 + i))/file1.txt" "$REPO/pkg9/mod9/file9.txt"
+        local start end
+        start=$(date +%s.%N)
+        git -C "$REPO" status --porcelain >/dev/null
+        end=$(date +%s.%N)
+        best=$(awk -v s="$start" -v e="$end" -v b="$best" \
+            'BEGIN { t = e - s; if (b == "" || t < b) b = t; print b }')
+    done
+    echo "$best"
+}
+
+[ -d "$REPO/.git" ] || create_repo
+
+"$BIN" --fsmonitor-uninstall "$TREE" >/dev/null
+git -C "$REPO" config core.untrackedCache true
+git -C "$REPO" status --porcelain >/dev/null
+before=$(time_status)
+
+"$BIN" --fsmonitor-install "$TREE" >/dev/null
+"$BIN" --watch 3600 "$TREE" >/dev/null 2>&1 &
+daemon=$!
+trap 'kill $daemon 2>/dev/null; "$BIN" --fsmonitor-uninstall "$TREE" >/dev/null' EXIT
+
+# Serving starts once the journal has a header
+for _ in $(seq 1 100); do
+    [ -s "$REPO/.git/gitsync-fsmonitor" ] && break
+    sleep 0.1
+done
+git -C "$REPO" status --porcelain >/dev/null
+after=$(time_status)
+
+printf 'git status, %s files: %.3fs without fsmonitor, %.3fs with gitsync (best of %s)\n' \
+    "$(git -C "$REPO" ls-files | wc -l)" "$before" "$after" "$ROUNDS"
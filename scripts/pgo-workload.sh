@@ -0,0 +1,101 @@
+#!/bin/bash
+# GitSync - PGO training / benchmark workload
+# Usage: pgo-workload.sh BINARY WORKDIR [ROUNDS]
+#
+# Runs an offline workload against a synthetic repository farm (created in
+# WORKDIR on first use): a full scan with batch status probing, simulated
+# filter typing in the TUI, and the simple list. Prints the best CPU time
+# of the gitsync processes themselves over ROUNDS runs (GITSYNC_CPU_REPORT,
+# so the forked git commands, which PGO cannot speed up, are not counted).
+# No network access is needed; remotes are local bare repos.
+
+set -e
+
+BIN="$1"
+WORKDIR="$2"
+ROUNDS="${3:-1}"
+
+if [ -z "$BIN" ] || [ -z "$WORKDIR" ]; then
+    echo "Usage: $0 BINARY WORKDIR [ROUNDS]" >&2
+    exit 2
+fi
+
+mkdir -p "$WORKDIR"
+WORKDIR=$(cd "$WORKDIR" && pwd)
+FARM="$WORKDIR/farm"
+
+# Keep the user's gitsync data and git config out of the workload
+export HOME="$WORKDIR/home"
+mkdir -p "$HOME"
+GROUPS_N=4
+REPOS_PER_GROUP=20
+
+git_quiet() {
+    git -c user.name=gitsync -c user.email=gitsync@localhost -c init.defaultBranch=main "$@" >/dev/null 2>&1
+}
+
+create_farm() {
+    mkdir -p "$FARM"
+    for g in $(seq 1 $GROUPS_N); do
+        for r in $(seq 1 $REPOS_PER_GROUP); do
+            local repo="$FARM/group$g/project-$g-$r"
+            local origin="$WORKDIR/origins/project-$g-$r.git"
+            git_quiet init --bare "$origin"
+            git_quiet init "$repo"
+            mkdir -p "$repo/src/module"
+            for f in $(seq 1 10); do
+                echo "file $f of $repo" > "$repo/src/module/file$f.txt"
+            done
+            git_quiet -C "$repo" add -A
+            git_quiet -C "$repo" commit -m "initial"
+            git_quiet -C "$repo" remote add origin "$origin"
+            git_quiet -C "$repo" push origin main
+            # Mix of states: dirty worktrees and unpushed commits
+            if [ $((r % 3)) -eq 0 ]; then
+                echo "edit" >> "$repo/src/module/file1.txt"
+            fi
+            if [ $((r % 4)) -eq 0 ]; then
+                git_quiet -C "$repo" commit --allow-empty -m "local"
+            fi
+        done
+    done
+}
+
+run_once() {
+    # Batch status: discovery plus full local and remote probing
+    "$BIN" --watch 0 --cycles 2 --metrics-file "$WORKDIR/metrics.prom" "$FARM" >/dev/null
+
+    # Filter typing in the TUI: type, backspace, navigate, rescan, quit.
+    # Repeated so filtering and rendering dominate gitsync's own CPU time.
+    {
+        printf '\n'
+        for _ in $(seq 1 20); do
+            printf 'project-1'
+            printf '\177\177'
+            printf '\033[B\033[B\033[A'
+            printf '\025project-3-1'
+            printf '\177\177\177\177\177\177\177\177\177\177\177'
+            printf '\025'
+        done
+        printf '\022'
+        printf 'n'
+        printf 'q'
+    } | "$BIN" --interface tui "$FARM" >/dev/null
+
+    # Simple list probes everything up front
+    printf '0\n' | "$BIN" --interface simple "$FARM" >/dev/null
+}
+
+[ -d "$FARM" ] || create_farm
+
+export GITSYNC_CPU_REPORT="$WORKDIR/cpu-report.$$"
+best=""
+for _ in $(seq 1 "$ROUNDS"); do
+    rm -f "$GITSYNC_CPU_REPORT"
+    run_once
+    cpu=$(awk '{ t += $1 + $2 } END { print t + 0 }' "$GITSYNC_CPU_REPORT")
+    best=$(awk -v t="$cpu" -v b="$best" 'BEGIN { if (b == "" || t < b) b = t; print b }')
+done
+rm -f "$GITSYNC_CPU_REPORT"
+
+printf '%s: %.3fs gitsync CPU (best of %s)\n' "$BIN" "$best" "$ROUNDS"
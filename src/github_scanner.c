@@ -8,10 +8,51 @@
 #include <termios.h>
 #include <ctype.h>
 #include <libgen.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <stdint.h>
+#include <sys/file.h>
+#include <sys/resource.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
 
-#define MAX_REPOS 100
 #define MAX_PATH_LEN 1024
 
+#define LIST_ROWS 10            // Repository rows visible in the TUI list
+#define PROBE_LOCAL_TTL 30      // Seconds before a worktree probe is stale
+#define PROBE_REMOTE_TTL 300    // Seconds before a remote probe is stale
+#define PROBE_IDLE_MS 1000      // Idle wait before re-checking staleness
+#define METRICS_BUCKETS 12      // Finite histogram buckets, see metrics_bounds
+#define GIT_TIMEOUT_LOCAL 30    // Seconds allowed for local git queries
+#define GIT_TIMEOUT_NETWORK 120 // Default seconds for fetch, pull and push
+#define GIT_TIMEOUT_COMMIT 600 // Seconds for add and commit, hooks included
+#define GIT_TIMEOUT_MAINTENANCE 1800 // Seconds for repack and fsck
+#define ESC_SEQUENCE_MS 30      // Wait telling a lone Esc from an arrow key
+#define REPO_LOG_SIZE 8192      // Bytes of git output kept per repository
+#define LOG_PANE_ROWS 17        // Log lines shown in the TUI log pane
+#define SYNC_LOG_TAIL_LINES 10  // Log lines printed when a sync step fails
+
+#define GIT_FAILED -1           // run_git(): could not run or killed by a signal
+#define GIT_TIMED_OUT -2        // run_git(): deadline passed, process group killed
+#define GIT_CANCELLED -3        // run_git(): Esc pressed in the TUI
+
+#define FSMONITOR_JOURNAL "gitsync-fsmonitor"       // Event journal in .git
+#define FSMONITOR_COOKIE_PREFIX "gitsync-cookie-"   // Sync cookies in .git
+#define FSMONITOR_COOKIE_MS 500                     // Max wait for the daemon to see a cookie
+#define FSMONITOR_JOURNAL_MAX (4L * 1024 * 1024)    // Journal bytes before it restarts
+
+#define STATE_COMPACT_RATIO 4  // Sync state lines per repository before compacting
+
+#define JOURNAL_FSYNC_BATCH 16  // Journal records allowed between fsyncs
+#define JOURNAL_FSYNC_INTERVAL 1.0 // Max seconds a journal record stays unsynced
+
 #define COLOR_GREEN  "\033[1;32m"
 #define COLOR_YELLOW "\033[1;33m"
 #define COLOR_RED    "\033[1;31m"
@@ -22,6 +63,11 @@
 #define COLOR_DIM    "\033[2;37m"
 #define COLOR_BOLD   "\033[1m"
 
+typedef struct {
+    char data[REPO_LOG_SIZE];
+    unsigned long long written; // Total bytes ever appended
+} RingLog;
+
 typedef struct {
     char name[256];
     char path[MAX_PATH_LEN];
@@ -31,6 +77,14 @@ typedef struct {
     int has_local_changes;
     int has_remote_changes;
     int sync_status;
+    time_t local_probed_at;     // 0 until branch/remote/worktree are probed
+    time_t remote_probed_at;    // 0 until the remote has been fetched
+    int ahead;                  // Local commits not on origin/main
+    int behind;                 // origin/main commits not in HEAD
+    time_t last_sync_at;        // Last sync that completed without error
+    time_t last_failure_at;     // Last sync that failed or timed out
+    int sync_failures;          // Failed syncs since the last success
+    RingLog log;                // Recent git output, see run_git()
 } Repository;
 
 typedef enum {
@@ -53,9 +107,36 @@ typedef enum {
     SYNC_COMMITTING,
     SYNC_PUSHING,
     SYNC_DONE,
-    SYNC_ERROR
+    SYNC_ERROR,
+    SYNC_TIMEOUT,
+    SYNC_CANCELLED
 } SyncState;
 
+typedef enum {
+    OP_SCAN,
+    OP_STATUS,
+    OP_FETCH,
+    OP_PULL,
+    OP_COMMIT,
+    OP_PUSH,
+    OP_COUNT
+} MetricOp;
+
+typedef struct {
+    unsigned long buckets[METRICS_BUCKETS + 1]; // Last slot is +Inf
+    unsigned long count;
+    double sum;
+} Histogram;
+
+typedef struct {
+    FILE* fp;                   // NULL when no journal is open
+    char path[MAX_PATH_LEN];
+    int unsynced;               // Records written since the last fsync
+    double last_fsync;
+    char** carried;             // Records of repositories outside this scan
+    int carried_count;
+} SyncJournal;
+
 typedef struct {
     InterfaceMode mode;
     const char* scan_dir;
@@ -63,15 +144,53 @@ typedef struct {
     CommitMode commit_mode;
     int show_help;
     int show_version;
+    const char* metrics_file;
+    int metrics_port;
+    int watch_interval;         // Seconds between watch cycles, -1 when off
+    int watch_cycles;           // 0 runs until interrupted
+    int sync_all;
+    const char* journal_path;
+    int git_timeout;            // Seconds for network git ops
+    const char* log_dir;
+    int clone_groups;           // 1 lists clone groups, 2 also links them
+    int fsmonitor_install;      // 1 installs the hook, -1 removes it
+    int fsmonitor_query;        // Set when git runs us as core.fsmonitor
+    int fsmonitor_version;
+    const char* fsmonitor_token;
 } ProgramConfig;
 
-Repository repos[MAX_REPOS];
+Repository* repos = NULL;       // Grown by append_repo(), no fixed limit
 static int repo_count = 0;
+static int repo_capacity = 0;
 static int loading_active = 0;
 
 static char filter_text[256] = "";
 static int filtered_count = 0;
 
+static const char* metric_op_names[OP_COUNT] = {
+    "scan", "status", "fetch", "pull", "commit", "push"
+};
+static const double metrics_bounds[METRICS_BUCKETS] = {
+    0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10, 30
+};
+static Histogram op_histograms[OP_COUNT];
+
+static const char* sync_state_names[] = {
+    "planned", "scanning", "fetching", "pulling", "committing", "pushing", "done", "error",
+    "timeout", "cancelled"
+};
+static SyncJournal journal;
+static char state_path[MAX_PATH_LEN] = "";  // Persisted sync results, see state_load()
+static int metrics_listen_fd = -1;          // Served from every wait, see service_fds()
+
+static int git_network_timeout = GIT_TIMEOUT_NETWORK;
+static int git_cancel_enabled = 0;  // Esc cancels git ops while the tty is in raw mode
+static volatile pid_t git_child_pid = 0; // Running git, killed by handle_exit_signal()
+static char log_dir[MAX_PATH_LEN] = "";  // --log-dir, empty when off
+static int fsmonitor_inotify_fd = -1;    // Open while watch mode serves fsmonitor
+static char key_queue[64];          // Keys read while watching for Esc
+static int key_queue_len = 0;
+
 void show_error(const char* message);
 void show_warning(const char* message);
 void show_success(const char* message);
@@ -124,6 +243,427 @@ void stop_loading(void) {
     }
 }
 
+static double monotonic_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void observe_duration(MetricOp op, double started) {
+    double seconds = monotonic_seconds() - started;
+    Histogram* h = &op_histograms[op];
+    int bucket = 0;
+    
+    while (bucket < METRICS_BUCKETS && seconds > metrics_bounds[bucket]) bucket++;
+    h->buckets[bucket]++;
+    h->count++;
+    h->sum += seconds;
+}
+
+static int input_pending(int timeout_ms) {
+    if (key_queue_len > 0) return 1;
+    
+    fd_set fds;
+    struct timeval tv;
+    
+    FD_ZERO(&fds);
+    FD_SET(STDIN_FILENO, &fds);
+    tv.tv_sec = timeout_ms / 1000;
+    tv.tv_usec = (timeout_ms % 1000) * 1000;
+    return select(STDIN_FILENO + 1, &fds, NULL, NULL, &tv) > 0;
+}
+
+/* Next keystroke, preferring input that arrived while a git op was running */
+static int read_key(void) {
+    if (key_queue_len > 0) {
+        int ch = (unsigned char)key_queue[0];
+        memmove(key_queue, key_queue + 1, (size_t)--key_queue_len);
+        return ch;
+    }
+    return getchar();
+}
+
+/*
+ * Drain tty input that arrives during a git op. A lone Esc cancels the op;
+ * anything else (including escape sequences such as arrow keys) is queued
+ * for read_key(). Returns 1 to cancel, 0 to keep watching, -1 to stop
+ * watching (EOF or a full queue).
+ */
+static int poll_cancel_key(void) {
+    char buf[sizeof(key_queue)];
+    size_t room = sizeof(key_queue) - (size_t)key_queue_len;
+    
+    ssize_t n = read(STDIN_FILENO, buf, room);
+    if (n <= 0) return -1;
+    if (n == 1 && buf[0] == '\033') {
+        fd_set fds;
+        struct timeval tv = { 0, ESC_SEQUENCE_MS * 1000 };
+        FD_ZERO(&fds);
+        FD_SET(STDIN_FILENO, &fds);
+        if (select(STDIN_FILENO + 1, &fds, NULL, NULL, &tv) <= 0) return 1;
+    }
+    
+    memcpy(key_queue + key_queue_len, buf, (size_t)n);
+    key_queue_len += (int)n;
+    return key_queue_len < (int)sizeof(key_queue) ? 0 : -1;
+}
+
+static int git_interrupted(int result) {
+    return result == GIT_TIMED_OUT || result == GIT_CANCELLED;
+}
+
+static void kill_git(pid_t pid) {
+    kill(-pid, SIGKILL);
+    kill(pid, SIGKILL);
+}
+
+static struct termios old_termios, new_termios;
+
+/*
+ * SIGINT, SIGTERM and SIGHUP: git runs in its own session, so it would not
+ * get the signal and could keep hanging (and holding index.lock) after we
+ * are gone. Kill its process group, restore the terminal, then die from
+ * the same signal. Only async-signal-safe calls here.
+ */
+static void handle_exit_signal(int sig) {
+    if (git_child_pid > 0) kill_git(git_child_pid);
+    if (git_cancel_enabled) tcsetattr(STDIN_FILENO, TCSANOW, &old_termios);
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+static int add_service_fds(fd_set* fds, int max_fd);
+static void service_fds(const fd_set* fds);
+
+static Repository* find_repo_by_path(const char* path) {
+    for (int i = 0; i < repo_count; i++) {
+        if (strcmp(repos[i].path, path) == 0) return &repos[i];
+    }
+    return NULL;
+}
+
+static void ring_log_append(RingLog* log, const char* data, size_t len) {
+    // Only the newest REPO_LOG_SIZE bytes can survive anyway
+    if (len > REPO_LOG_SIZE) {
+        log->written += len - REPO_LOG_SIZE;
+        data += len - REPO_LOG_SIZE;
+        len = REPO_LOG_SIZE;
+    }
+    
+    size_t pos = (size_t)(log->written % REPO_LOG_SIZE);
+    size_t first = len < REPO_LOG_SIZE - pos ? len : REPO_LOG_SIZE - pos;
+    memcpy(log->data + pos, data, first);
+    memcpy(log->data, data + first, len - first);
+    log->written += len;
+}
+
+/*
+ * Copy the retained log, oldest first, into out (REPO_LOG_SIZE + 1 bytes).
+ * Once the ring has wrapped, the partial oldest line is dropped.
+ */
+static size_t ring_log_read(const RingLog* log, char* out) {
+    size_t len = log->written < REPO_LOG_SIZE ? (size_t)log->written : REPO_LOG_SIZE;
+    size_t start = (size_t)((log->written - len) % REPO_LOG_SIZE);
+    size_t first = len < REPO_LOG_SIZE - start ? len : REPO_LOG_SIZE - start;
+    
+    memcpy(out, log->data + start, first);
+    memcpy(out + first, log->data, len - first);
+    out[len] = '\0';
+    
+    if (log->written > REPO_LOG_SIZE) {
+        char* newline = memchr(out, '\n', len);
+        if (newline) {
+            len -= (size_t)(newline + 1 - out);
+            memmove(out, newline + 1, len + 1);
+        }
+    }
+    return len;
+}
+
+/* Print the last max_lines lines of a repository's log, e.g. after a failed step */
+static void print_log_tail(const char* path, int max_lines) {
+    Repository* repo = find_repo_by_path(path);
+    if (!repo) return;
+    
+    static char text[REPO_LOG_SIZE + 1];
+    size_t len = ring_log_read(&repo->log, text);
+    
+    const char* start = text + len;
+    int lines = 0;
+    while (start > text) {
+        if (start[-1] == '\n' && start != text + len && ++lines >= max_lines) break;
+        start--;
+    }
+    if (*start) printf("%s%s%s", COLOR_DIM, start, COLOR_RESET);
+}
+
+/*
+ * Spill file for path under --log-dir, named after the canonical path with
+ * '/' as '_'. '_' and '%' are escaped as %5F and %25, so no two
+ * repositories can share a file.
+ */
+static FILE* open_log_spill(const char* path) {
+    if (!log_dir[0]) return NULL;
+    
+    char file_path[MAX_PATH_LEN * 4];
+    int n = snprintf(file_path, sizeof(file_path), "%s/", log_dir);
+    for (const char* p = path; *p && n < (int)sizeof(file_path) - 8; p++) {
+        if (*p == '_' || *p == '%') {
+            n += snprintf(file_path + n, sizeof(file_path) - (size_t)n, "%%%02X", (unsigned char)*p);
+        } else {
+            file_path[n++] = *p == '/' ? '_' : *p;
+        }
+    }
+    snprintf(file_path + n, sizeof(file_path) - (size_t)n, ".log");
+    return fopen(file_path, "ae");
+}
+
+/*
+ * Where run_git() output goes: the repository's ring log and optional
+ * spill file. Output of repositories gitsync does not track (and has no
+ * spill file for) is echoed to stdout so it is never silently lost.
+ */
+typedef struct {
+    Repository* repo;
+    FILE* spill;
+    const char* header;         // Logged before the first output, then NULL
+} GitLog;
+
+static void git_log_write(GitLog* log, const char* data, size_t len) {
+    if (log->header) {
+        const char* header = log->header;
+        log->header = NULL;
+        git_log_write(log, header, strlen(header));
+    }
+    
+    if (log->repo) ring_log_append(&log->repo->log, data, len);
+    if (log->spill) fwrite(data, 1, len, log->spill);
+    if (!log->repo && !log->spill) {
+        fwrite(data, 1, len, stdout);
+        fflush(stdout);
+    }
+}
+
+/*
+ * Run `git ARGS...` in path with a deadline. The child gets its own
+ * session (no controlling terminal, so nothing can prompt on the tty) and a
+ * non-interactive environment.
+ *
+ * With out == NULL the call is an operation (fetch, pull, commit, push):
+ * the command line, all output and any failure are written to the
+ * repository's log. Otherwise it is a query: stdout is copied into out and
+ * only stderr and failures are logged. Once out is full the child is killed
+ * and the call counts as successful, like piping into `head`.
+ *
+ * Returns git's exit code, GIT_FAILED if it could not run or died from a
+ * signal, GIT_TIMED_OUT after timeout_sec, or GIT_CANCELLED if Esc was
+ * pressed in the TUI. Timeouts and cancels kill the whole process group.
+ */
+static int run_git(const char* path, const char* const args[], int timeout_sec, char* out, size_t out_size) {
+    const char* argv[32];
+    int argc = 0;
+    
+    argv[argc++] = "git";
+    while (args[argc - 1] && argc < (int)(sizeof(argv) / sizeof(argv[0])) - 1) {
+        argv[argc] = args[argc - 1];
+        argc++;
+    }
+    argv[argc] = NULL;
+    
+    if (out && out_size > 0) out[0] = '\0';
+    
+    char header[512];
+    time_t now = time(NULL);
+    size_t header_len = strftime(header, sizeof(header), "[%H:%M:%S] $", localtime(&now));
+    for (int i = 0; i < argc && header_len < sizeof(header) - 2; i++) {
+        header_len += (size_t)snprintf(header + header_len, sizeof(header) - header_len, " %s", argv[i]);
+    }
+    if (header_len > sizeof(header) - 2) header_len = sizeof(header) - 2;
+    header[header_len++] = '\n';
+    header[header_len] = '\0';
+    
+    GitLog log = { find_repo_by_path(path), open_log_spill(path), header };
+    if (!out) git_log_write(&log, "", 0);
+    
+    int out_fds[2], err_fds[2];
+    if (pipe(out_fds) != 0) {
+        if (log.spill) fclose(log.spill);
+        return GIT_FAILED;
+    }
+    if (pipe(err_fds) != 0) {
+        close(out_fds[0]);
+        close(out_fds[1]);
+        if (log.spill) fclose(log.spill);
+        return GIT_FAILED;
+    }
+    
+    // Keep exit signals out until git_child_pid is set, see handle_exit_signal()
+    sigset_t exit_signals, saved_mask;
+    sigemptyset(&exit_signals);
+    sigaddset(&exit_signals, SIGINT);
+    sigaddset(&exit_signals, SIGTERM);
+    sigaddset(&exit_signals, SIGHUP);
+    sigprocmask(SIG_BLOCK, &exit_signals, &saved_mask);
+    
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid > 0) git_child_pid = pid;
+    if (pid != 0) sigprocmask(SIG_SETMASK, &saved_mask, NULL);
+    if (pid < 0) {
+        close(out_fds[0]);
+        close(out_fds[1]);
+        close(err_fds[0]);
+        close(err_fds[1]);
+        if (log.spill) fclose(log.spill);
+        return GIT_FAILED;
+    }
+    
+    if (pid == 0) {
+        setsid();
+        signal(SIGINT, SIG_DFL);
+        signal(SIGTERM, SIG_DFL);
+        signal(SIGHUP, SIG_DFL);
+        sigprocmask(SIG_SETMASK, &saved_mask, NULL);
+        int null_fd = open("/dev/null", O_RDONLY);
+        dup2(null_fd, STDIN_FILENO);
+        dup2(out_fds[1], STDOUT_FILENO);
+        dup2(err_fds[1], STDERR_FILENO);
+        close(out_fds[0]);
+        close(err_fds[0]);
+        
+        setenv("GIT_TERMINAL_PROMPT", "0", 1);
+        setenv("GIT_MERGE_AUTOEDIT", "no", 1);
+        setenv("GCM_INTERACTIVE", "never", 1);
+        // No tty in this session; keep ssh from falling back to askpass dialogs
+        setenv("SSH_ASKPASS_REQUIRE", "never", 1);
+        if (fsmonitor_inotify_fd >= 0) {
+            // Events were drained just before; the hook need not wait on a cookie
+            setenv("GITSYNC_FSMONITOR_SYNCED", "1", 1);
+        }
+        
+        if (chdir(path) == 0) {
+            execvp("git", (char* const*)argv);
+        }
+        _exit(127);
+    }
+    
+    close(out_fds[1]);
+    close(err_fds[1]);
+    
+    double deadline = monotonic_seconds() + timeout_sec;
+    int watch_keys = git_cancel_enabled && isatty(STDIN_FILENO);
+    int fds[2] = { out_fds[0], err_fds[0] };
+    int result = GIT_FAILED;
+    int stopped = 0;            // Set once the child has been killed
+    size_t used = 0;
+    
+    while (fds[0] >= 0 || fds[1] >= 0) {
+        double remaining = deadline - monotonic_seconds();
+        if (remaining <= 0) {
+            result = GIT_TIMED_OUT;
+            stopped = 1;
+            break;
+        }
+        
+        fd_set read_fds;
+        int max_fd = STDIN_FILENO;
+        FD_ZERO(&read_fds);
+        for (int i = 0; i < 2; i++) {
+            if (fds[i] < 0) continue;
+            FD_SET(fds[i], &read_fds);
+            if (fds[i] > max_fd) max_fd = fds[i];
+        }
+        if (watch_keys) FD_SET(STDIN_FILENO, &read_fds);
+        max_fd = add_service_fds(&read_fds, max_fd);
+        struct timeval tv = { (time_t)remaining, (long)((remaining - (time_t)remaining) * 1e6) };
+        
+        int ready = select(max_fd + 1, &read_fds, NULL, NULL, &tv);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            stopped = 1;
+            break;
+        }
+        
+        service_fds(&read_fds);
+        
+        if (watch_keys && FD_ISSET(STDIN_FILENO, &read_fds)) {
+            int key = poll_cancel_key();
+            if (key == 1) {
+                result = GIT_CANCELLED;
+                stopped = 1;
+                break;
+            }
+            if (key < 0) watch_keys = 0;
+        }
+        
+        for (int i = 0; i < 2 && !stopped; i++) {
+            if (fds[i] < 0 || !FD_ISSET(fds[i], &read_fds)) continue;
+            
+            char chunk[4096];
+            ssize_t n = read(fds[i], chunk, sizeof(chunk));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) {
+                close(fds[i]);
+                fds[i] = -1;
+                continue;
+            }
+            
+            if (i == 1 || !out) {
+                git_log_write(&log, chunk, (size_t)n);
+            } else if (out_size > 0) {
+                size_t room = out_size - 1 - used;
+                size_t copy = (size_t)n < room ? (size_t)n : room;
+                memcpy(out + used, chunk, copy);
+                used += copy;
+                out[used] = '\0';
+                if ((size_t)n >= room) {
+                    result = 0;
+                    stopped = 1;
+                }
+            }
+        }
+        if (stopped) break;
+    }
+    
+    for (int i = 0; i < 2; i++) {
+        if (fds[i] >= 0) close(fds[i]);
+    }
+    
+    // Output is closed; give git until the deadline to exit
+    int status;
+    if (stopped) kill_git(pid);
+    while (waitpid(pid, &status, stopped ? 0 : WNOHANG) == 0) {
+        if (monotonic_seconds() >= deadline) {
+            result = GIT_TIMED_OUT;
+            stopped = 1;
+            kill_git(pid);
+            continue;
+        }
+        struct timespec ts = { 0, 1000000 };
+        nanosleep(&ts, NULL);
+    }
+    
+    git_child_pid = 0;
+    if (!stopped) {
+        result = WIFEXITED(status) ? WEXITSTATUS(status) : GIT_FAILED;
+    }
+    
+    char trailer[64];
+    if (result == GIT_TIMED_OUT) {
+        snprintf(trailer, sizeof(trailer), "[timed out after %ds]\n", timeout_sec);
+    } else if (result == GIT_CANCELLED) {
+        snprintf(trailer, sizeof(trailer), "[cancelled]\n");
+    } else if (result != 0 && !out) {
+        snprintf(trailer, sizeof(trailer), "[exit %d]\n", result);
+    } else {
+        trailer[0] = '\0';
+    }
+    if (trailer[0]) git_log_write(&log, trailer, strlen(trailer));
+    
+    if (log.spill) fclose(log.spill);
+    return result;
+}
+
 static int is_git_repo(const char* path) {
     char git_path[1024];
     struct stat st;
@@ -132,75 +672,240 @@ static int is_git_repo(const char* path) {
 }
 
 static int has_local_changes(const char *path) {
-    char cmd[MAX_PATH_LEN * 2];
+    const char* args[] = { "status", "--porcelain", NULL };
     char buffer[256];
-    int has_changes = 0;
     
-    snprintf(cmd, sizeof(cmd), "cd \"%s\" && git status --porcelain 2>/dev/null | head -1", path);
-    FILE *fp = popen(cmd, "r");
-    if (!fp) return 0;
+    double started = monotonic_seconds();
+    int result = run_git(path, args, GIT_TIMEOUT_LOCAL, buffer, sizeof(buffer));
+    observe_duration(OP_STATUS, started);
     
-    if (fgets(buffer, sizeof(buffer), fp)) {
-        has_changes = 1;
-    }
-    pclose(fp);
-    return has_changes;
+    if (git_interrupted(result)) return result;
+    return result == 0 && buffer[0] != '\0';
 }
 
-static int has_remote_changes(const char *path) {
-    char cmd[MAX_PATH_LEN * 2];
+/*
+ * Fetch origin/main and count how far HEAD has diverged from it. Returns
+ * whether there is anything to pull (or GIT_TIMED_OUT / GIT_CANCELLED);
+ * ahead/behind stay -1 if the fetch fails.
+ */
+static int probe_remote_changes(const char *path, int *ahead, int *behind) {
+    const char* fetch_args[] = { "fetch", "origin", "main", NULL };
+    const char* count_args[] = { "rev-list", "--left-right", "--count", "HEAD...origin/main", NULL };
     char buffer[256];
-    int has_changes = 0;
     
-    snprintf(cmd, sizeof(cmd), "cd \"%s\" && git fetch origin main 2>/dev/null && git log HEAD..origin/main --oneline 2>/dev/null | head -1", path);
-    FILE *fp = popen(cmd, "r");
-    if (!fp) return 0;
+    *ahead = -1;
+    *behind = -1;
+    
+    double started = monotonic_seconds();
+    int result = run_git(path, fetch_args, git_network_timeout, NULL, 0);
+    observe_duration(OP_FETCH, started);
+    if (git_interrupted(result)) return result;
+    if (result != 0) return 0;
     
-    if (fgets(buffer, sizeof(buffer), fp)) {
-        has_changes = 1;
+    result = run_git(path, count_args, GIT_TIMEOUT_LOCAL, buffer, sizeof(buffer));
+    if (git_interrupted(result)) return result;
+    if (result != 0 || sscanf(buffer, "%d %d", ahead, behind) != 2) {
+        *ahead = -1;
+        *behind = -1;
+    }
+    return *behind > 0;
+}
+
+
+/* First line of a git query's stdout, or fallback if it fails or prints nothing */
+static void git_query_line(const char* path, const char* const args[], char* value, size_t value_size,
+                           const char* fallback) {
+    int result = run_git(path, args, GIT_TIMEOUT_LOCAL, value, value_size);
+    value[strcspn(value, "\n")] = '\0';
+    if (result != 0 || value[0] == '\0') {
+        snprintf(value, value_size, "%s", fallback);
     }
-    pclose(fp);
-    return has_changes;
 }
 
 static void get_branch_name(const char *path, char *branch, size_t branch_size) {
-    char cmd[MAX_PATH_LEN * 2];
-    FILE *fp;
+    const char* args[] = { "branch", "--show-current", NULL };
+    git_query_line(path, args, branch, branch_size, "unknown");
+}
+
+static void get_remote_url(const char *path, char *remote, size_t remote_size) {
+    const char* args[] = { "remote", "get-url", "origin", NULL };
+    git_query_line(path, args, remote, remote_size, "No remote");
+}
+
+/*
+ * $XDG_DATA_HOME/gitsync/<name> (default ~/.local/share/gitsync), creating
+ * the directories on the way. Not a cache directory: linked clones borrow
+ * objects from here and the journal holds resume state, so nothing in it
+ * may be deleted by cache cleaners. Returns -1, leaving buffer empty, if
+ * the path does not fit: a truncated path would point somewhere else.
+ */
+static int gitsync_data_path(char* buffer, size_t size, const char* name) {
+    const char* data_home = getenv("XDG_DATA_HOME");
+    char base[MAX_PATH_LEN];
+    int n;
+    
+    buffer[0] = '\0';
+    if (data_home && data_home[0] == '/') {
+        n = snprintf(base, sizeof(base), "%s", data_home);
+    } else {
+        const char* home = getenv("HOME");
+        if (!home || !home[0]) home = ".";
+        n = snprintf(base, sizeof(base), "%s/.local/share", home);
+    }
+    if (n < 0 || (size_t)n >= sizeof(base)) return -1;
+    
+    // mkdir -p, ignoring components that already exist
+    for (char* p = base + 1; *p; p++) {
+        if (*p != '/') continue;
+        *p = '\0';
+        mkdir(base, 0755);
+        *p = '/';
+    }
+    mkdir(base, 0755);
+    
+    n = snprintf(buffer, size, "%s/gitsync", base);
+    if (n >= 0 && (size_t)n < size) {
+        mkdir(buffer, 0755);
+        n = snprintf(buffer, size, "%s/gitsync/%s", base, name);
+    }
+    if (n < 0 || (size_t)n >= size) {
+        buffer[0] = '\0';
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * If path was linked by --share-objects, store its shared cache repository
+ * (the alternates entry minus "/objects") in cache and return 1.
+ */
+static int shared_cache_of(const char* path, char* cache, size_t cache_size) {
+    char file_path[MAX_PATH_LEN + 64];
+    char cache_root[MAX_PATH_LEN];
+    
+    snprintf(file_path, sizeof(file_path), "%s/.git/objects/info/alternates", path);
+    FILE* fp = fopen(file_path, "r");
+    if (!fp) return 0;
     
-    strcpy(branch, "unknown");
+    int found = fgets(cache, (int)cache_size, fp) != NULL;
+    fclose(fp);
+    if (!found) return 0;
     
-    snprintf(cmd, sizeof(cmd), "cd \"%s\" && git branch --show-current 2>/dev/null || echo 'unknown'", path);
-    fp = popen(cmd, "r");
-    if (fp) {
-        if (fgets(branch, branch_size, fp)) {
-            branch[strcspn(branch, "\n")] = '\0';
-        }
-        pclose(fp);
+    cache[strcspn(cache, "\n")] = '\0';
+    if (gitsync_data_path(cache_root, sizeof(cache_root), "objects/") != 0) return 0;
+    size_t len = strlen(cache);
+    if (strncmp(cache, cache_root, strlen(cache_root)) != 0 || len < 8 || strcmp(cache + len - 8, "/objects") != 0) {
+        return 0;
     }
+    cache[len - 8] = '\0';
+    return 1;
 }
 
-static void get_remote_url(const char *path, char *remote, size_t remote_size) {
-    char cmd[MAX_PATH_LEN * 2];
-    FILE *fp;
+/*
+ * Before a linked clone fetches, bring its group's shared cache up to date
+ * (at most once per PROBE_REMOTE_TTL for the whole group). The clone's own
+ * fetch then finds every object in the cache and only updates refs. Run
+ * from the clone so the output lands in its log.
+ */
+static int refresh_shared_cache(const char* path) {
+    char cache[MAX_PATH_LEN];
+    char fetch_head[MAX_PATH_LEN + 16];
+    struct stat st;
     
-    strcpy(remote, "No remote");
+    if (!shared_cache_of(path, cache, sizeof(cache))) return 0;
+    
+    snprintf(fetch_head, sizeof(fetch_head), "%s/FETCH_HEAD", cache);
+    if (stat(fetch_head, &st) == 0 && time(NULL) - st.st_mtime < PROBE_REMOTE_TTL) return 0;
+    
+    const char* args[] = { "-C", cache, "fetch", "--quiet", "origin", NULL };
+    return run_git(path, args, git_network_timeout, NULL, 0);
+}
+
+static int probe_is_stale(time_t probed_at, int ttl) {
+    return probed_at == 0 || time(NULL) - probed_at >= ttl;
+}
+
+static int repo_needs_probe(const Repository* repo, int want_remote) {
+    if (probe_is_stale(repo->local_probed_at, PROBE_LOCAL_TTL)) return 1;
+    return want_remote && probe_is_stale(repo->remote_probed_at, PROBE_REMOTE_TTL);
+}
+
+static SyncState interrupted_state(int result) {
+    return result == GIT_TIMED_OUT ? SYNC_TIMEOUT : SYNC_CANCELLED;
+}
+
+/*
+ * Refresh whatever is stale for one repository. The worktree probe is
+ * local and cheap; the remote probe runs a network fetch, so callers only
+ * ask for it on rows the user is actually looking at. A timed out or
+ * cancelled probe still counts as fresh, so one hung repository is not
+ * retried until its TTL expires (or Ctrl+R).
+ */
+static void probe_repo(Repository* repo, int want_remote) {
+    int probe_local = probe_is_stale(repo->local_probed_at, PROBE_LOCAL_TTL);
+    int probe_remote = want_remote && probe_is_stale(repo->remote_probed_at, PROBE_REMOTE_TTL);
+    
+    if (!probe_local && !probe_remote) return;
+    if (repo->sync_status == SYNC_TIMEOUT || repo->sync_status == SYNC_CANCELLED) {
+        repo->sync_status = SYNC_IDLE;
+    }
     
-    snprintf(cmd, sizeof(cmd), "cd \"%s\" && git remote get-url origin 2>/dev/null || echo 'No remote'", path);
-    fp = popen(cmd, "r");
-    if (fp) {
-        if (fgets(remote, remote_size, fp)) {
-            remote[strcspn(remote, "\n")] = '\0';
+    if (probe_local) {
+        get_branch_name(repo->path, repo->branch, sizeof(repo->branch));
+        get_remote_url(repo->path, repo->remote, sizeof(repo->remote));
+        int result = has_local_changes(repo->path);
+        if (git_interrupted(result)) {
+            repo->sync_status = interrupted_state(result);
+        } else {
+            repo->has_local_changes = result;
+        }
+        repo->local_probed_at = time(NULL);
+    }
+    if (probe_remote) {
+        int ahead = -1, behind = -1;
+        int result = refresh_shared_cache(repo->path);
+        if (!git_interrupted(result)) {
+            result = probe_remote_changes(repo->path, &ahead, &behind);
+        }
+        if (git_interrupted(result)) {
+            repo->sync_status = interrupted_state(result);
+        } else {
+            repo->has_remote_changes = result;
         }
-        pclose(fp);
+        // An interrupted fetch leaves -1: unknown, not "in sync"
+        repo->ahead = ahead;
+        repo->behind = behind;
+        repo->remote_probed_at = time(NULL);
     }
 }
 
 static void get_repo_info(Repository* repo) {
-    get_branch_name(repo->path, repo->branch, sizeof(repo->branch));
-    get_remote_url(repo->path, repo->remote, sizeof(repo->remote));
-    repo->has_local_changes = has_local_changes(repo->path);
-    repo->has_remote_changes = has_remote_changes(repo->path);
+    probe_repo(repo, 1);
+}
+
+/*
+ * Record a discovered repository without probing it; see probe_repo().
+ * The path is canonicalized so the journal, logs and metrics key a
+ * repository the same way however the scan directory was spelled.
+ */
+static void init_repo(Repository* repo, const char* full_path) {
+    memset(repo, 0, sizeof(*repo));
+    repo->is_git = 1;
     repo->sync_status = SYNC_IDLE;
+    strcpy(repo->branch, "unknown");
+    strcpy(repo->remote, "No remote");
+    repo->ahead = -1;
+    repo->behind = -1;
+    
+    const char* dir_name = strrchr(full_path, '/');
+    if (dir_name) dir_name++;
+    else dir_name = full_path;
+    
+    strncpy(repo->name, dir_name, sizeof(repo->name) - 1);
+    
+    char* resolved = realpath(full_path, NULL);
+    snprintf(repo->path, sizeof(repo->path), "%s", resolved ? resolved : full_path);
+    free(resolved);
 }
 
 static int is_excluded_path(const char* path) {
@@ -218,9 +923,19 @@ static int is_excluded_path(const char* path) {
     return 0;
 }
 
+/* Room for one more repository at repos[repo_count], or NULL when out of memory */
+static Repository* append_repo(void) {
+    if (repo_count == repo_capacity) {
+        int capacity = repo_capacity ? repo_capacity * 2 : 64;
+        Repository* grown = realloc(repos, sizeof(Repository) * (size_t)capacity);
+        if (!grown) return NULL;
+        repos = grown;
+        repo_capacity = capacity;
+    }
+    return &repos[repo_count];
+}
+
 static void add_repo_from_path(const char* full_path) {
-    if (repo_count >= MAX_REPOS) return;
-    
     if (is_excluded_path(full_path)) return;
     
     struct stat st;
@@ -231,19 +946,9 @@ static void add_repo_from_path(const char* full_path) {
     
     if (stat(git_path, &st) != 0 || !S_ISDIR(st.st_mode)) return;
     
-    Repository *repo = &repos[repo_count];
-    repo->is_git = 1;
-    
-    const char* dir_name = strrchr(full_path, '/');
-    if (dir_name) dir_name++;
-    else dir_name = full_path;
-    
-    strncpy(repo->name, dir_name, sizeof(repo->name) - 1);
-    repo->name[sizeof(repo->name) - 1] = '\0';
-    strncpy(repo->path, full_path, sizeof(repo->path) - 1);
-    repo->path[sizeof(repo->path) - 1] = '\0';
-    
-    get_repo_info(repo);
+    Repository* repo = append_repo();
+    if (!repo) return;
+    init_repo(repo, full_path);
     repo_count++;
 }
 
@@ -259,7 +964,7 @@ static void scan_system_for_repos(void) {
     if (!fp) return;
     
     char line[MAX_PATH_LEN];
-    while (fgets(line, sizeof(line), fp) && repo_count < MAX_REPOS) {
+    while (fgets(line, sizeof(line), fp)) {
         line[strcspn(line, "\n")] = '\0';
         if (strlen(line) > 1) {
             add_repo_from_path(line);
@@ -273,24 +978,9 @@ static void scan_directory(const char *path, int depth) {
     
     // Check if current path is a git repository
     if (is_git_repo(path)) {
-        if (repo_count < MAX_REPOS) {
-            // Extract repo name from path
-            const char *base = strrchr(path, '/');
-            if (base) {
-                base++; // Skip the '/'
-            } else {
-                base = path;
-            }
-            
-            strncpy(repos[repo_count].name, base, sizeof(repos[repo_count].name) - 1);
-            strncpy(repos[repo_count].path, path, sizeof(repos[repo_count].path) - 1);
-            repos[repo_count].name[sizeof(repos[repo_count].name) - 1] = '\0';
-            repos[repo_count].path[sizeof(repos[repo_count].path) - 1] = '\0';
-            
-            repos[repo_count].has_local_changes = has_local_changes(path);
-            repos[repo_count].has_remote_changes = has_remote_changes(path);
-            get_branch_name(path, repos[repo_count].branch, sizeof(repos[repo_count].branch));
-            
+        Repository* repo = append_repo();
+        if (repo) {
+            init_repo(repo, path);
             repo_count++;
         }
         return; // Don't scan inside a git repo
@@ -318,6 +1008,7 @@ Repository* scan_github_repos(const char* root_dir, int* count) {
     
     printf("\n");
     start_loading("Scanning for Git repositories");
+    double started = monotonic_seconds();
     
     if (strcmp(root_dir, ".") == 0 || root_dir[0] == '\0') {
         scan_system_for_repos();
@@ -326,6 +1017,7 @@ Repository* scan_github_repos(const char* root_dir, int* count) {
         scan_directory(root_dir, 0);
     }
     
+    observe_duration(OP_SCAN, started);
     stop_loading();
     printf(" done\n");
     
@@ -339,17 +1031,17 @@ Repository* scan_github_repos(const char* root_dir, int* count) {
     return repos;
 }
 
-static struct termios old_termios, new_termios;
-
 static void enable_raw_mode(void) {
     tcgetattr(STDIN_FILENO, &old_termios);
     new_termios = old_termios;
     new_termios.c_lflag &= ~(ICANON | ECHO);
     tcsetattr(STDIN_FILENO, TCSANOW, &new_termios);
+    git_cancel_enabled = 1;
 }
 
 static void disable_raw_mode(void) {
     tcsetattr(STDIN_FILENO, TCSANOW, &old_termios);
+    git_cancel_enabled = 0;
 }
 
 static void draw_header(void) {
@@ -365,39 +1057,93 @@ static void draw_header(void) {
     draw_separator_line(4, 80);
 }
 
-static void draw_repo_list(int cursor_pos) {
+static int get_filtered_count(void) {
+    if (strlen(filter_text) == 0) return repo_count;
+    
+    int count = 0;
+    for (int i = 0; i < repo_count; i++) {
+        if (strstr(repos[i].name, filter_text) != NULL) {
+            count++;
+        }
+    }
+    return count;
+}
+
+static int get_filtered_index(int visible_index) {
+    if (strlen(filter_text) == 0) return visible_index;
+    
+    int count = 0;
+    for (int i = 0; i < repo_count; i++) {
+        if (strstr(repos[i].name, filter_text) != NULL) {
+            if (count == visible_index) return i;
+            count++;
+        }
+    }
+    return 0;
+}
+
+static void draw_repo_status(const Repository* repo) {
+    if (repo->sync_status == SYNC_TIMEOUT) {
+        printf("%s [!]%s", COLOR_RED, COLOR_RESET);
+        return;
+    }
+    if (repo->sync_status == SYNC_CANCELLED) {
+        printf("%s [x]%s", COLOR_DIM, COLOR_RESET);
+        return;
+    }
+    if (repo->local_probed_at == 0) {
+        printf("%s [?]%s", COLOR_DIM, COLOR_RESET);
+        return;
+    }
+    
+    // Results past their TTL stay visible, dimmed, until re-probed
+    int local_stale = probe_is_stale(repo->local_probed_at, PROBE_LOCAL_TTL);
+    int remote_stale = probe_is_stale(repo->remote_probed_at, PROBE_REMOTE_TTL);
+    
+    if (repo->has_local_changes) {
+        printf("%s [+]%s", local_stale ? COLOR_DIM : COLOR_YELLOW, COLOR_RESET);
+    }
+    if (repo->has_remote_changes) {
+        printf("%s [↓]%s", remote_stale ? COLOR_DIM : COLOR_CYAN, COLOR_RESET);
+    }
+    if (!repo->has_local_changes && !repo->has_remote_changes) {
+        // Clean is only a bright claim once the remote has been checked too
+        printf("%s [✓]%s", local_stale || remote_stale ? COLOR_DIM : COLOR_GREEN, COLOR_RESET);
+    }
+}
+
+static void draw_repo_list(int cursor_pos, int list_offset) {
     int start_y = 5;
     
     printf("\033[%d;1H", start_y);
-    printf("%sRepositories:%s\n", COLOR_CYAN, COLOR_RESET);
+    printf("%sRepositories:%s", COLOR_CYAN, COLOR_RESET);
+    if (filtered_count > LIST_ROWS) {
+        int last = list_offset + LIST_ROWS < filtered_count ? list_offset + LIST_ROWS : filtered_count;
+        printf(" %s(%d-%d of %d)%s", COLOR_DIM, list_offset + 1, last, filtered_count, COLOR_RESET);
+    }
+    printf("\n");
     
-    for (int i = 0; i < repo_count; i++) {
-        printf("\033[%d;3H", start_y + 1 + i);
+    for (int row = 0; row < LIST_ROWS && list_offset + row < filtered_count; row++) {
+        int visible = list_offset + row;
+        Repository* repo = &repos[get_filtered_index(visible)];
+        
+        printf("\033[%d;3H", start_y + 1 + row);
         
-        if (i == cursor_pos) {
-            printf("%s▶ %s%s", COLOR_GREEN, COLOR_WHITE, repos[i].name);
+        if (visible == cursor_pos) {
+            printf("%s▶ %s%s", COLOR_GREEN, COLOR_WHITE, repo->name);
         } else {
-            printf("  %s", repos[i].name);
+            printf("  %s", repo->name);
         }
         
-        // Status indicators
-        if (repos[i].has_local_changes) {
-            printf("%s [+]%s", COLOR_YELLOW, COLOR_RESET);
-        }
-        if (repos[i].has_remote_changes) {
-            printf("%s [↓]%s", COLOR_CYAN, COLOR_RESET);
-        }
-        if (!repos[i].has_local_changes && !repos[i].has_remote_changes) {
-            printf("%s [✓]%s", COLOR_GREEN, COLOR_RESET);
-        }
+        draw_repo_status(repo);
     }
 }
 
 static void draw_selected_details(int cursor_pos) {
-    if (cursor_pos < 0 || cursor_pos >= repo_count) return;
+    if (cursor_pos < 0 || cursor_pos >= filtered_count) return;
     
-    Repository* repo = &repos[cursor_pos];
-    int details_start = 5 + repo_count + 2;
+    Repository* repo = &repos[get_filtered_index(cursor_pos)];
+    int details_start = 5 + LIST_ROWS + 2;
     
     printf("\033[%d;1H", details_start);
     printf("\n%sSelected Repository:%s\n", COLOR_YELLOW, COLOR_RESET);
@@ -408,6 +1154,16 @@ static void draw_selected_details(int cursor_pos) {
     
     // Status
     printf("  Status: ");
+    if (repo->sync_status == SYNC_TIMEOUT || repo->sync_status == SYNC_CANCELLED) {
+        printf("%s%s%s %s(Ctrl+R to retry)%s\n", COLOR_RED,
+               repo->sync_status == SYNC_TIMEOUT ? "Git timed out" : "Cancelled",
+               COLOR_RESET, COLOR_DIM, COLOR_RESET);
+        return;
+    }
+    if (repo->local_probed_at == 0) {
+        printf("%sProbing...%s\n", COLOR_DIM, COLOR_RESET);
+        return;
+    }
     if (repo->has_local_changes) {
         printf("%sHas local changes%s", COLOR_YELLOW, COLOR_RESET);
     }
@@ -417,87 +1173,207 @@ static void draw_selected_details(int cursor_pos) {
     if (!repo->has_local_changes && !repo->has_remote_changes) {
         printf("%sClean%s", COLOR_GREEN, COLOR_RESET);
     }
+    if (repo->remote_probed_at == 0) {
+        printf(" %s(remote not checked)%s", COLOR_DIM, COLOR_RESET);
+    } else {
+        printf(" %s(fetched %lds ago)%s", COLOR_DIM, (long)(time(NULL) - repo->remote_probed_at), COLOR_RESET);
+    }
     printf("\n");
 }
 
-static void draw_filter_info(void) {
-    printf("\033[1;1H");
-    printf("Filter: %s%s%s", COLOR_GREEN, filter_text, COLOR_RESET);
-    if (strlen(filter_text) > 0) {
-        printf(" (%d matches)", filtered_count);
+/*
+ * Log pane: replaces the list and details with the cursor row's captured
+ * git output. *scroll counts lines back from the newest and is clamped to
+ * what the ring buffer holds.
+ */
+static void draw_log_pane(int cursor_pos, int* scroll) {
+    static char text[REPO_LOG_SIZE + 1];
+    static const char* lines[REPO_LOG_SIZE + 1];
+    int start_y = 5;
+    
+    if (cursor_pos < 0 || cursor_pos >= filtered_count) return;
+    Repository* repo = &repos[get_filtered_index(cursor_pos)];
+    
+    printf("\033[%d;1H", start_y);
+    printf("%sLog: %s%s %s(Tab: back | Scroll: ↑↓ PgUp PgDn)%s\n",
+           COLOR_CYAN, repo->name, COLOR_RESET, COLOR_DIM, COLOR_RESET);
+    
+    ring_log_read(&repo->log, text);
+    int count = 0;
+    for (char* p = text; *p; ) {
+        lines[count++] = p;
+        char* newline = strchr(p, '\n');
+        if (!newline) break;
+        *newline = '\0';
+        p = newline + 1;
+    }
+    
+    if (count == 0) {
+        printf("\033[%d;3H%sNo git output captured yet%s", start_y + 1, COLOR_DIM, COLOR_RESET);
+        return;
+    }
+    
+    int max_scroll = count > LOG_PANE_ROWS ? count - LOG_PANE_ROWS : 0;
+    if (*scroll > max_scroll) *scroll = max_scroll;
+    if (*scroll < 0) *scroll = 0;
+    
+    int first = count - LOG_PANE_ROWS - *scroll;
+    if (first < 0) first = 0;
+    
+    for (int row = 0; row < LOG_PANE_ROWS && first + row < count; row++) {
+        printf("\033[%d;3H", start_y + 1 + row);
+        
+        // Printable text only, cut at the pane width (counting UTF-8 chars)
+        int columns = 0;
+        for (const unsigned char* c = (const unsigned char*)lines[first + row]; *c && columns < 76; c++) {
+            if (*c < 32 || *c == 127) continue;
+            if ((*c & 0xC0) != 0x80) columns++;
+            putchar(*c);
+        }
+    }
+}
+
+static void draw_filter_info(void) {
+    printf("\033[1;1H");
+    printf("Filter: %s%s%s", COLOR_GREEN, filter_text, COLOR_RESET);
+    if (strlen(filter_text) > 0) {
+        printf(" (%d matches)", filtered_count);
     }
     printf("\n");
 }
 
 static void draw_help_bar(void) {
     printf("\033[24;1H");
-    printf("%sNavigation: ↑↓/jk  | Select: Enter | Filter: type letters | Clear: Backspace | Quit: q | Rescan: n%s", COLOR_DIM, COLOR_RESET);
+    printf("%sNavigation: ↑↓/jk  | Select: Enter | Filter: type letters | Clear: Backspace | Refresh: Ctrl+R | Log: Tab | Cancel git: Esc | Quit: q | Rescan: n%s", COLOR_DIM, COLOR_RESET);
     printf("\033[K"); // Clear rest of line
 }
 
-static int get_filtered_count(void) {
-    if (strlen(filter_text) == 0) return repo_count;
+/*
+ * Pick the next repository to probe, most visible first: the cursor row
+ * (including its remote), the rest of the viewport, the viewport's remotes,
+ * and finally off-screen rows in the background (worktree only). Returns -1
+ * when nothing is stale.
+ */
+static int next_probe_target(int cursor_pos, int list_offset, int* want_remote, int* on_screen) {
+    *want_remote = 1;
+    *on_screen = 1;
+    
+    if (filtered_count > 0) {
+        int idx = get_filtered_index(cursor_pos);
+        if (repo_needs_probe(&repos[idx], 1)) return idx;
+    }
     
-    int count = 0;
-    for (int i = 0; i < repo_count; i++) {
-        if (strstr(repos[i].name, filter_text) != NULL) {
-            count++;
+    for (int pass = 0; pass < 2; pass++) {
+        for (int row = 0; row < LIST_ROWS && list_offset + row < filtered_count; row++) {
+            int idx = get_filtered_index(list_offset + row);
+            if (repo_needs_probe(&repos[idx], pass)) {
+                *want_remote = pass;
+                return idx;
+            }
         }
     }
-    return count;
-}
-
-static int get_filtered_index(int visible_index) {
-    if (strlen(filter_text) == 0) return visible_index;
     
-    int count = 0;
+    *want_remote = 0;
+    *on_screen = 0;
     for (int i = 0; i < repo_count; i++) {
-        if (strstr(repos[i].name, filter_text) != NULL) {
-            if (count == visible_index) return i;
-            count++;
-        }
+        if (repo_needs_probe(&repos[i], 0)) return i;
     }
-    return 0;
+    return -1;
 }
 
-
-
 static char* tui_select_repo(const char* scan_dir, CommitMode commit_mode) {
     (void)commit_mode;
     if (repo_count == 0) {
         return NULL;
     }
     
+    // Unbuffered so input_pending() sees every keystroke not yet consumed
+    setvbuf(stdin, NULL, _IONBF, 0);
+    
     printf("\nPress any key to start...");
-    getchar();
+    read_key();
     
     int running = 1;
     int cursor_pos = 0;
+    int list_offset = 0;
+    int show_log = 0;
+    int log_scroll = 0;
+    int redraw = 1;
     char* selected = NULL;
     
     enable_raw_mode();
     
     while (running) {
-        filtered_count = get_filtered_count();
+        if (redraw) {
+            filtered_count = get_filtered_count();
+            if (cursor_pos >= filtered_count) cursor_pos = filtered_count > 0 ? filtered_count - 1 : 0;
+            if (cursor_pos < list_offset) list_offset = cursor_pos;
+            if (cursor_pos >= list_offset + LIST_ROWS) list_offset = cursor_pos - LIST_ROWS + 1;
+            
+            draw_header();
+            draw_filter_info();
+            if (show_log) {
+                draw_log_pane(cursor_pos, &log_scroll);
+            } else {
+                draw_repo_list(cursor_pos, list_offset);
+                draw_selected_details(cursor_pos);
+            }
+            draw_help_bar();
+            fflush(stdout);
+            redraw = 0;
+        }
         
-        draw_header();
-        draw_filter_info();
-        draw_repo_list(cursor_pos);
-        draw_selected_details(cursor_pos);
-        draw_help_bar();
+        // Probe one repository per iteration so a keystroke never waits
+        // behind more than a single probe
+        if (!input_pending(0)) {
+            int want_remote, on_screen;
+            int target = next_probe_target(cursor_pos, list_offset, &want_remote, &on_screen);
+            if (target >= 0) {
+                probe_repo(&repos[target], want_remote);
+                redraw = on_screen;
+                continue;
+            }
+            if (!input_pending(PROBE_IDLE_MS)) continue;
+        }
         
-        int ch = getchar();
+        int ch = read_key();
+        redraw = 1;
         
-        if (ch == '\033') {
-            getchar(); // Skip [
-            int arrow_key = getchar();
+        if (ch == EOF) {
+            running = 0;
+        } else if (ch == '\033') {
+            // A lone Esc only matters while a git op runs (see run_git)
+            if (!input_pending(ESC_SEQUENCE_MS)) continue;
+            read_key(); // Skip [
+            int arrow_key = read_key();
+            if (arrow_key == '5' || arrow_key == '6') read_key(); // Skip ~ of PgUp/PgDn
             switch(arrow_key) {
                 case 'A':
-                    if (cursor_pos > 0) cursor_pos--;
+                    if (show_log) log_scroll++;
+                    else if (cursor_pos > 0) cursor_pos--;
                     break;
                 case 'B':
-                    if (cursor_pos < filtered_count - 1) cursor_pos++;
+                    if (show_log) log_scroll--;
+                    else if (cursor_pos < filtered_count - 1) cursor_pos++;
+                    break;
+                case '5':
+                    if (show_log) log_scroll += LOG_PANE_ROWS;
                     break;
+                case '6':
+                    if (show_log) log_scroll -= LOG_PANE_ROWS;
+                    break;
+            }
+        } else if (ch == '\t') { // Toggle the log pane for the cursor row
+            show_log = !show_log;
+            log_scroll = 0;
+        } else if (ch == 18) { // Ctrl+R - force a full re-probe of the cursor row
+            if (filtered_count > 0) {
+                Repository* repo = &repos[get_filtered_index(cursor_pos)];
+                repo->local_probed_at = 0;
+                repo->remote_probed_at = 0;
+                if (repo->sync_status == SYNC_TIMEOUT || repo->sync_status == SYNC_CANCELLED) {
+                    repo->sync_status = SYNC_IDLE;
+                }
             }
         } else if (ch >= 32 && ch <= 126) { // Printable characters
             if (ch == 'q' || ch == 'Q') {
@@ -521,6 +1397,7 @@ static char* tui_select_repo(const char* scan_dir, CommitMode commit_mode) {
                 scan_github_repos(scan_dir, &repo_count);
                 enable_raw_mode();
                 cursor_pos = 0;
+                list_offset = 0;
             } else {
                 // Add to filter
                 size_t len = strlen(filter_text);
@@ -550,6 +1427,11 @@ static char* simple_select_repo(void) {
         return NULL;
     }
     
+    // The list shows every repository at once, so probe them all up front
+    for (int i = 0; i < repo_count; i++) {
+        get_repo_info(&repos[i]);
+    }
+    
     printf("\n%s[%s]%s Available repositories:\n", COLOR_BLUE, "LIST", COLOR_RESET);
     for (int i = 0; i < repo_count; i++) {
         char status[32] = "";
@@ -616,7 +1498,323 @@ static char* select_repository_interface(InterfaceMode mode, const char* scan_di
     return selected;
 }
 
-static void sync_repository(const char* path, CommitMode commit_mode) {
+/*
+ * Sync results outlive the process so metrics can alert on repositories
+ * that stay unsynced or keep failing, whichever process did the sync. The
+ * state file holds "<success>\t<failure>\t<failures>\t<path>\n" records
+ * (Unix times, 0 for never; failures since the last success). Writers only
+ * append one record per sync and the last record per path wins.
+ */
+typedef struct {
+    time_t success_at;
+    time_t failure_at;
+    int failures;
+    char* path;
+} SyncStateRecord;
+
+static int parse_state_record(char* line, SyncStateRecord* record) {
+    size_t len = strlen(line);
+    if (len == 0 || line[len - 1] != '\n') return -1;  // Torn final line
+    line[len - 1] = '\0';
+    
+    long long success_at, failure_at;
+    int failures, path_offset;
+    if (sscanf(line, "%lld\t%lld\t%d\t%n", &success_at, &failure_at, &failures, &path_offset) != 3) return -1;
+    
+    record->success_at = (time_t)success_at;
+    record->failure_at = (time_t)failure_at;
+    record->failures = failures;
+    record->path = line + path_offset;
+    return 0;
+}
+
+static void write_state_record(FILE* fp, const SyncStateRecord* record) {
+    fprintf(fp, "%lld\t%lld\t%d\t%s\n", (long long)record->success_at, (long long)record->failure_at,
+            record->failures, record->path);
+}
+
+/*
+ * Load persisted sync results into the scanned repositories. With compact
+ * set (only before syncing, never from watch mode) a file that has grown
+ * past STATE_COMPACT_RATIO records per repository is rewritten with the
+ * newest record per path, repositories outside this scan included.
+ */
+static void state_load(int compact) {
+    FILE* fp = fopen(state_path, "r");
+    if (!fp) return;
+    
+    SyncStateRecord* records = NULL;
+    int count = 0, lines = 0;
+    char line[MAX_PATH_LEN + 80];
+    
+    while (fgets(line, sizeof(line), fp)) {
+        SyncStateRecord record;
+        if (parse_state_record(line, &record) != 0) continue;
+        lines++;
+        
+        Repository* repo = find_repo_by_path(record.path);
+        if (repo) {
+            repo->last_sync_at = record.success_at;
+            repo->last_failure_at = record.failure_at;
+            repo->sync_failures = record.failures;
+        }
+        if (!compact) continue;
+        
+        int i = 0;
+        while (i < count && strcmp(records[i].path, record.path) != 0) i++;
+        if (i == count) {
+            SyncStateRecord* grown = realloc(records, sizeof(SyncStateRecord) * (size_t)(count + 1));
+            if (!grown) break;
+            records = grown;
+            records[count++].path = strdup(record.path);
+        }
+        records[i].success_at = record.success_at;
+        records[i].failure_at = record.failure_at;
+        records[i].failures = record.failures;
+    }
+    fclose(fp);
+    
+    if (compact && lines > count * STATE_COMPACT_RATIO) {
+        char tmp_path[MAX_PATH_LEN + 32];
+        snprintf(tmp_path, sizeof(tmp_path), "%s.%d.tmp", state_path, (int)getpid());
+        FILE* out = fopen(tmp_path, "w");
+        if (out) {
+            for (int i = 0; i < count; i++) write_state_record(out, &records[i]);
+            if (fflush(out) != 0 || fsync(fileno(out)) != 0 || fclose(out) != 0 || rename(tmp_path, state_path) != 0) {
+                unlink(tmp_path);
+            }
+        }
+    }
+    for (int i = 0; i < count; i++) free(records[i].path);
+    free(records);
+}
+
+/* Persist the outcome of one sync; a cancelled sync is neither */
+static void record_sync_result(const char* path, SyncState state) {
+    Repository* repo = find_repo_by_path(path);
+    if (!repo || state == SYNC_CANCELLED) return;
+    
+    if (state == SYNC_DONE) {
+        repo->last_sync_at = time(NULL);
+        repo->sync_failures = 0;
+    } else {
+        repo->last_failure_at = time(NULL);
+        repo->sync_failures++;
+    }
+    
+    if (!state_path[0]) return;
+    FILE* fp = fopen(state_path, "a");
+    if (!fp) return;
+    SyncStateRecord record = { repo->last_sync_at, repo->last_failure_at, repo->sync_failures, repo->path };
+    write_state_record(fp, &record);
+    fclose(fp);
+}
+
+static SyncState parse_sync_state(const char* name) {
+    for (int i = SYNC_IDLE; i <= SYNC_CANCELLED; i++) {
+        if (strcmp(sync_state_names[i], name) == 0) return (SyncState)i;
+    }
+    return (SyncState)-1;
+}
+
+/* Keep the newest record of a repository outside this scan, see journal_write() */
+static void journal_carry(const char* record, const char* path) {
+    for (int i = 0; i < journal.carried_count; i++) {
+        if (strcmp(strchr(journal.carried[i], '\t') + 1, path) == 0) {
+            free(journal.carried[i]);
+            journal.carried[i] = strdup(record);
+            return;
+        }
+    }
+    
+    char** grown = realloc(journal.carried, sizeof(char*) * (size_t)(journal.carried_count + 1));
+    if (!grown) return;
+    journal.carried = grown;
+    journal.carried[journal.carried_count++] = strdup(record);
+}
+
+/*
+ * Restore each repository's sync_status from a previous, interrupted run's
+ * journal. Records are "<state>\t<path>\n" with canonical paths and the
+ * last one per path wins; a torn final line (no newline) or an unknown
+ * state is ignored. Records of repositories outside this scan (another
+ * scan root sharing the journal) are kept aside and written back.
+ */
+static void journal_load(const char* journal_path) {
+    FILE* fp = fopen(journal_path, "r");
+    if (!fp) return;
+    
+    char line[MAX_PATH_LEN + 32];
+    while (fgets(line, sizeof(line), fp)) {
+        size_t len = strlen(line);
+        if (len == 0 || line[len - 1] != '\n') continue;
+        line[len - 1] = '\0';
+        
+        char* tab = strchr(line, '\t');
+        if (!tab) continue;
+        *tab = '\0';
+        
+        SyncState state = parse_sync_state(line);
+        if ((int)state < 0) continue;
+        
+        Repository* repo = find_repo_by_path(tab + 1);
+        if (repo) {
+            repo->sync_status = state;
+        } else {
+            *tab = '\t';
+            journal_carry(line, tab + 1);
+        }
+    }
+    fclose(fp);
+}
+
+/*
+ * Atomically replace the journal with the carried records plus, when
+ * include_scan is set, the current state of every scanned repository.
+ * With nothing to write the journal is removed.
+ */
+static int journal_write(const char* journal_path, int include_scan) {
+    if (journal.carried_count == 0 && !include_scan) {
+        return unlink(journal_path) == 0 || errno == ENOENT ? 0 : -1;
+    }
+    
+    char tmp_path[MAX_PATH_LEN + 32];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.%d.tmp", journal_path, (int)getpid());
+    
+    FILE* fp = fopen(tmp_path, "w");
+    if (!fp) return -1;
+    
+    for (int i = 0; i < journal.carried_count; i++) {
+        fprintf(fp, "%s\n", journal.carried[i]);
+    }
+    for (int i = 0; include_scan && i < repo_count; i++) {
+        fprintf(fp, "%s\t%s\n", sync_state_names[repos[i].sync_status], repos[i].path);
+    }
+    if (fflush(fp) != 0 || fsync(fileno(fp)) != 0 || fclose(fp) != 0 || rename(tmp_path, journal_path) != 0) {
+        unlink(tmp_path);
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Hold <journal>.lock for a whole run, so two --sync-all runs never work
+ * the same journal and state file. The journal itself is replaced by
+ * rename and cannot carry the lock. Returns the descriptor to close at
+ * the end of the run, or -1 with errno EWOULDBLOCK while another run
+ * holds it.
+ */
+static int journal_lock(const char* journal_path) {
+    char lock_path[MAX_PATH_LEN + 8];
+    snprintf(lock_path, sizeof(lock_path), "%s.lock", journal_path);
+    
+    int fd = open(lock_path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) return -1;
+    if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+        return -1;
+    }
+    return fd;
+}
+
+/*
+ * Start a journal for this run: the current state of every repository is
+ * written to a fresh file (which also compacts the previous run's records)
+ * and made durable before any repository is touched.
+ */
+static int journal_open(const char* journal_path) {
+    if (journal_write(journal_path, 1) != 0) return -1;
+    
+    journal.fp = fopen(journal_path, "ae");
+    if (!journal.fp) return -1;
+    snprintf(journal.path, sizeof(journal.path), "%s", journal_path);
+    journal.unsynced = 0;
+    journal.last_fsync = monotonic_seconds();
+    return 0;
+}
+
+/*
+ * Append a phase transition. Every record is flushed to the kernel, so it
+ * survives SIGINT or a dropped session; fsync is amortized over
+ * JOURNAL_FSYNC_BATCH records or JOURNAL_FSYNC_INTERVAL seconds. Losing the
+ * unsynced tail on a host crash only means re-running a phase, and every
+ * phase is safe to repeat.
+ */
+static SyncState journal_record(const char* path, SyncState state) {
+    Repository* repo = find_repo_by_path(path);
+    if (repo) repo->sync_status = state;
+    
+    if (!journal.fp) return state;
+    
+    fprintf(journal.fp, "%s\t%s\n", sync_state_names[state], path);
+    fflush(journal.fp);
+    journal.unsynced++;
+    
+    double now = monotonic_seconds();
+    if (journal.unsynced >= JOURNAL_FSYNC_BATCH || now - journal.last_fsync >= JOURNAL_FSYNC_INTERVAL) {
+        fsync(fileno(journal.fp));
+        journal.unsynced = 0;
+        journal.last_fsync = now;
+    }
+    return state;
+}
+
+/*
+ * The run reached its end, so nothing of this scan needs resuming: its
+ * records are dropped (failures included, the next run retries them from
+ * the start and re-checks the others) and only carried records remain.
+ * A run that never gets here leaves the journal for the next one.
+ */
+static void journal_close(void) {
+    if (!journal.fp) return;
+    
+    fclose(journal.fp);
+    journal.fp = NULL;
+    if (journal_write(journal.path, 0) != 0) {
+        show_warning("Could not finish sync journal; the next run may skip repositories");
+    }
+}
+
+static SyncState sync_interrupted(const char* path, int result) {
+    printf("\n");
+    print_log_tail(path, SYNC_LOG_TAIL_LINES);
+    if (result == GIT_TIMED_OUT) {
+        show_error("Git timed out - remote unreachable or waiting for credentials");
+    } else {
+        show_warning("Cancelled");
+    }
+    return journal_record(path, interrupted_state(result));
+}
+
+/*
+ * Keep what a sync step learned about a repository, as probe_repo() would,
+ * so a one-shot --metrics-file run exports it too.
+ */
+static void store_local_probe(const char* path, int local_changes) {
+    Repository* repo = find_repo_by_path(path);
+    if (!repo || git_interrupted(local_changes)) return;
+    repo->has_local_changes = local_changes;
+    repo->local_probed_at = time(NULL);
+}
+
+static void store_remote_probe(const char* path, int remote_changes, int ahead, int behind) {
+    Repository* repo = find_repo_by_path(path);
+    if (!repo) return;
+    if (!git_interrupted(remote_changes)) repo->has_remote_changes = remote_changes;
+    repo->ahead = ahead;
+    repo->behind = behind;
+    repo->remote_probed_at = time(NULL);
+}
+
+/*
+ * Sync one repository, starting at resume_from. The journal records each
+ * phase as it is entered, so an interrupted run resumes by repeating the
+ * phase it was in: SYNC_PULLING skips the change check (the pull fetches
+ * anyway), SYNC_COMMITTING skips the pull, SYNC_PUSHING only pushes.
+ */
+static SyncState sync_repository_from(const char* path, CommitMode commit_mode, SyncState resume_from) {
     (void)commit_mode;
     
     /*
@@ -634,76 +1832,1223 @@ static void sync_repository(const char* path, CommitMode commit_mode) {
     
     if (!is_git_repo(path)) {
         printf("%s[%s]%s Not a git repository%s\n", COLOR_RED, "ERROR", COLOR_RESET, "");
-        return;
+        return journal_record(path, SYNC_ERROR);
     }
     
-    char cmd[2048];
     char final_commit_msg[512];
     time_t now = time(NULL);
     struct tm* t = localtime(&now);
     strftime(final_commit_msg, sizeof(final_commit_msg), "GitSync: %Y-%m-%d %H:%M", t);
     
-    // Check for changes first
-    printf("\n");
-    start_loading("Checking for changes...");
-    int local_changes = has_local_changes(path);
-    int remote_changes = has_remote_changes(path);
-    stop_loading();
+    int local_changes;
+    int remote_changes;
     
-    if (!local_changes && !remote_changes) {
-        printf("%s[%s]%s Vault is up to date\n", COLOR_GREEN, "OK", COLOR_RESET);
-        return;
+    if (resume_from <= SYNC_FETCHING) {
+        // Check for changes first
+        journal_record(path, SYNC_FETCHING);
+        printf("\n");
+        start_loading("Checking for changes...");
+        local_changes = has_local_changes(path);
+        store_local_probe(path, local_changes);
+        if (git_interrupted(local_changes)) {
+            remote_changes = local_changes;
+        } else {
+            int ahead, behind;
+            remote_changes = probe_remote_changes(path, &ahead, &behind);
+            store_remote_probe(path, remote_changes, ahead, behind);
+        }
+        stop_loading();
+        
+        if (git_interrupted(local_changes) || git_interrupted(remote_changes)) {
+            return sync_interrupted(path, git_interrupted(local_changes) ? local_changes : remote_changes);
+        }
+        if (!local_changes && !remote_changes) {
+            printf("%s[%s]%s Vault is up to date\n", COLOR_GREEN, "OK", COLOR_RESET);
+            return journal_record(path, SYNC_DONE);
+        }
+    } else {
+        // Resumed past the check: always push, a no-op if nothing is pending
+        printf("%s[%s]%s Resuming at %s\n", COLOR_BLUE, "INFO", COLOR_RESET, sync_state_names[resume_from]);
+        local_changes = has_local_changes(path);
+        store_local_probe(path, local_changes);
+        remote_changes = 1;
+        if (git_interrupted(local_changes)) return sync_interrupted(path, local_changes);
     }
     
     // Step 1: Pull remote changes first (like Obsidian-GitHub-Sync)
-    printf("\n");
-    start_loading("Pulling remote changes...");
-    snprintf(cmd, sizeof(cmd), "cd \"%s\" && git pull origin main 2>&1", path);
-    int pull_result = system(cmd);
-    stop_loading();
-    
-    if (pull_result != 0) {
-        printf("\n%s[%s]%s Pull failed - merge conflicts detected\n", COLOR_RED, "CONFLICT", COLOR_RESET);
-        printf("%s[%s]%s Resolve conflicts in your editor, then run sync again\n", COLOR_YELLOW, "HINT", COLOR_RESET);
-        return;
-    }
-    printf("%s[%s]%s Pulled remote changes\n", COLOR_GREEN, "OK", COLOR_RESET);
-    
-    // Step 2: Stage and commit local changes
-    if (local_changes) {
+    if (resume_from <= SYNC_PULLING) {
+        journal_record(path, SYNC_PULLING);
         printf("\n");
-        start_loading("Staging and committing local changes...");
-        snprintf(cmd, sizeof(cmd), "cd \"%s\" && git add -A && git commit -m \"%s\" 2>&1", path, final_commit_msg);
-        int commit_result = system(cmd);
+        start_loading("Pulling remote changes...");
+        const char* pull_args[] = { "pull", "origin", "main", NULL };
+        double started = monotonic_seconds();
+        int pull_result = run_git(path, pull_args, git_network_timeout, NULL, 0);
+        observe_duration(OP_PULL, started);
         stop_loading();
         
-        if (commit_result == 0) {
-            printf(" done\n");
-            show_success("Changes committed");
-        } else {
+        if (git_interrupted(pull_result)) return sync_interrupted(path, pull_result);
+        if (pull_result != 0) {
             printf(" failed\n");
-            show_error("Nothing to commit or commit failed");
+            print_log_tail(path, SYNC_LOG_TAIL_LINES);
+            printf("\n%s[%s]%s Pull failed - merge conflicts detected\n", COLOR_RED, "CONFLICT", COLOR_RESET);
+            printf("%s[%s]%s Resolve conflicts in your editor, then run sync again\n", COLOR_YELLOW, "HINT", COLOR_RESET);
+            return journal_record(path, SYNC_ERROR);
+        }
+        printf(" done\n");
+        printf("%s[%s]%s Pulled remote changes\n", COLOR_GREEN, "OK", COLOR_RESET);
+    }
+    
+    // Step 2: Stage and commit local changes
+    if (resume_from <= SYNC_COMMITTING) {
+        journal_record(path, SYNC_COMMITTING);
+        if (local_changes) {
+            printf("\n");
+            start_loading("Staging and committing local changes...");
+            const char* add_args[] = { "add", "-A", NULL };
+            const char* commit_args[] = { "commit", "-m", final_commit_msg, NULL };
+            double started = monotonic_seconds();
+            int commit_result = run_git(path, add_args, GIT_TIMEOUT_COMMIT, NULL, 0);
+            if (commit_result == 0) {
+                commit_result = run_git(path, commit_args, GIT_TIMEOUT_COMMIT, NULL, 0);
+            }
+            observe_duration(OP_COMMIT, started);
+            stop_loading();
+            
+            if (git_interrupted(commit_result)) return sync_interrupted(path, commit_result);
+            if (commit_result == 0) {
+                printf(" done\n");
+                show_success("Changes committed");
+            } else {
+                printf(" failed\n");
+                print_log_tail(path, SYNC_LOG_TAIL_LINES);
+                show_error("Nothing to commit or commit failed");
+            }
         }
     }
     
     // Step 3: Push changes
+    journal_record(path, SYNC_PUSHING);
     if (local_changes || remote_changes) {
         printf("\n");
         start_loading("Pushing to remote...");
-        snprintf(cmd, sizeof(cmd), "cd \"%s\" && git push origin main 2>&1", path);
-        int push_result = system(cmd);
+        const char* push_args[] = { "push", "origin", "main", NULL };
+        double started = monotonic_seconds();
+        int push_result = run_git(path, push_args, git_network_timeout, NULL, 0);
+        observe_duration(OP_PUSH, started);
         stop_loading();
         
-        if (push_result == 0) {
-            printf(" done\n");
-            show_success("Sync complete!");
-        } else {
+        if (git_interrupted(push_result)) return sync_interrupted(path, push_result);
+        if (push_result != 0) {
             printf(" failed\n");
+            print_log_tail(path, SYNC_LOG_TAIL_LINES);
             show_error("Push failed - may need to pull again");
+            return journal_record(path, SYNC_ERROR);
         }
+        printf(" done\n");
+        show_success("Sync complete!");
+        
+        // Pulled and pushed: HEAD matches origin/main; re-check the worktree
+        store_remote_probe(path, 0, 0, 0);
+        store_local_probe(path, has_local_changes(path));
     } else {
         printf("\n%s[%s]%s Sync complete\n", COLOR_GREEN, "OK", COLOR_RESET);
     }
+    return journal_record(path, SYNC_DONE);
+}
+
+/*
+ * Let Esc cancel pull, commit and push as well: the tty goes to raw mode
+ * for the duration of a sync (unless it already is) and comes back after.
+ */
+static int begin_sync_cancel(void) {
+    if (git_cancel_enabled || !isatty(STDIN_FILENO)) return 0;
+    enable_raw_mode();
+    printf("%s[%s]%s Press Esc to cancel the running git operation\n", COLOR_BLUE, "INFO", COLOR_RESET);
+    return 1;
+}
+
+static void end_sync_cancel(int started) {
+    if (!started) return;
+    disable_raw_mode();
+    key_queue_len = 0;
+}
+
+static void sync_repository(const char* path, CommitMode commit_mode) {
+    int cancel = begin_sync_cancel();
+    state_load(1);
+    record_sync_result(path, sync_repository_from(path, commit_mode, SYNC_IDLE));
+    end_sync_cancel(cancel);
+}
+
+/*
+ * Batch sync of every scanned repository. After an interrupted run,
+ * repositories the journal marks done are skipped, partial ones resume at
+ * their recorded phase and failed or timed out ones start over.
+ */
+static int run_sync_all(const ProgramConfig* config) {
+    int lock_fd = journal_lock(config->journal_path);
+    if (lock_fd < 0 && errno == EWOULDBLOCK) {
+        show_error("Another gitsync --sync-all run is using this journal");
+        return 1;
+    }
+    
+    journal_load(config->journal_path);
+    if (journal_open(config->journal_path) != 0) {
+        show_warning("Could not open sync journal; this run will not be resumable");
+    }
+    
+    int synced = 0, skipped = 0, failed = 0;
+    int cancel = begin_sync_cancel();
+    state_load(1);
+    
+    for (int i = 0; i < repo_count; i++) {
+        SyncState resume_from = (SyncState)repos[i].sync_status;
+        
+        if (resume_from == SYNC_DONE) {
+            skipped++;
+            continue;
+        }
+        if (resume_from >= SYNC_ERROR) resume_from = SYNC_IDLE;
+        
+        SyncState result = sync_repository_from(repos[i].path, config->commit_mode, resume_from);
+        record_sync_result(repos[i].path, result);
+        if (result == SYNC_DONE) {
+            synced++;
+        } else {
+            failed++;
+        }
+    }
+    
+    end_sync_cancel(cancel);
+    journal_close();
+    if (lock_fd >= 0) close(lock_fd);
+    
+    printf("\n%s[%s]%s %d synced, %d already done, %d failed\n",
+           failed ? COLOR_YELLOW : COLOR_GREEN, "SUMMARY", COLOR_RESET, synced, skipped, failed);
+    if (failed) {
+        printf("%s[%s]%s Run again to retry the failed repositories\n", COLOR_YELLOW, "HINT", COLOR_RESET);
+    }
+    return failed ? 1 : 0;
+}
+
+/*
+ * Reduce a remote URL to host/path so the https, ssh and scp-like forms of
+ * one repository compare equal: drop the scheme, user@, a trailing slash
+ * and ".git", and turn scp-style "host:path" into "host/path".
+ */
+static void normalize_remote_url(const char* url, char* out, size_t size) {
+    const char* scheme = strstr(url, "://");
+    int scp_like = !scheme && url[0] != '/' && strchr(url, ':');
+    if (scheme) url = scheme + 3;
+    
+    const char* at = strchr(url, '@');
+    const char* slash = strchr(url, '/');
+    if (at && (!slash || at < slash)) url = at + 1;
+    
+    snprintf(out, size, "%s", url);
+    if (scp_like) {
+        char* colon = strchr(out, ':');
+        if (colon) *colon = '/';
+    }
+    
+    size_t len = strlen(out);
+    while (len > 0 && out[len - 1] == '/') out[--len] = '\0';
+    if (len > 4 && strcmp(out + len - 4, ".git") == 0) out[len - 4] = '\0';
+}
+
+static char (*group_keys)[512];     // Per repository, while run_clone_groups() runs
+
+static int compare_group_keys(const void* a, const void* b) {
+    int ia = *(const int*)a, ib = *(const int*)b;
+    int cmp = strcmp(group_keys[ia], group_keys[ib]);
+    return cmp ? cmp : ia - ib;
+}
+
+/* Packed object size of a repository in KiB, from `git count-objects -v` */
+static long packed_size_kib(const char* path) {
+    const char* args[] = { "count-objects", "-v", NULL };
+    char output[1024];
+    
+    if (run_git(path, args, GIT_TIMEOUT_LOCAL, output, sizeof(output)) != 0) return -1;
+    
+    long size = 0, size_pack = 0;
+    const char* line = strstr(output, "\nsize: ");
+    if (line) size = atol(line + 7);
+    line = strstr(output, "size-pack: ");
+    if (line) size_pack = atol(line + 11);
+    return size + size_pack;
+}
+
+/*
+ * Why path must not be linked to cache_objects, or NULL if it is safe. A
+ * repack drops every object the cache also has, so the clone must not be
+ * mid-operation, must not already borrow from elsewhere, and no other
+ * scanned repository may be borrowing its objects.
+ */
+static const char* share_objects_blocker(const char* path) {
+    static const struct { const char* file; const char* reason; } busy[] = {
+        { "index.lock", "index is locked by another git process" },
+        { "gc.pid", "git gc is running" },
+        { "MERGE_HEAD", "merge in progress" },
+        { "rebase-merge", "rebase in progress" },
+        { "rebase-apply", "rebase or am in progress" },
+        { "CHERRY_PICK_HEAD", "cherry-pick in progress" },
+        { "REVERT_HEAD", "revert in progress" },
+        { "BISECT_LOG", "bisect in progress" },
+        { "shallow", "shallow clone" },
+        { "objects/info/alternates", "already borrows objects from another repository" },
+    };
+    static char reason[MAX_PATH_LEN + 64];
+    char file_path[MAX_PATH_LEN * 2];
+    struct stat st;
+    
+    for (size_t i = 0; i < sizeof(busy) / sizeof(busy[0]); i++) {
+        snprintf(file_path, sizeof(file_path), "%s/.git/%s", path, busy[i].file);
+        if (stat(file_path, &st) == 0) return busy[i].reason;
+    }
+    
+    char objects[MAX_PATH_LEN + 16];
+    snprintf(objects, sizeof(objects), "%s/.git/objects", path);
+    for (int i = 0; i < repo_count; i++) {
+        char line[MAX_PATH_LEN + 16];
+        snprintf(file_path, sizeof(file_path), "%s/.git/objects/info/alternates", repos[i].path);
+        FILE* fp = fopen(file_path, "r");
+        if (!fp) continue;
+        while (fgets(line, sizeof(line), fp)) {
+            line[strcspn(line, "\n")] = '\0';
+            if (strcmp(line, objects) == 0) {
+                fclose(fp);
+                snprintf(reason, sizeof(reason), "objects are borrowed by %s", repos[i].path);
+                return reason;
+            }
+        }
+        fclose(fp);
+    }
+    return NULL;
+}
+
+/*
+ * Create (or reuse) the bare cache for one remote and fetch it. The cache
+ * is never pruned or garbage collected: linked clones may depend on any
+ * object it has ever held.
+ */
+static int prepare_shared_cache(const char* cache, const char* url, const char* log_path) {
+    struct stat st;
+    
+    if (stat(cache, &st) != 0) {
+        const char* init_args[] = { "init", "--quiet", "--bare", cache, NULL };
+        if (run_git(log_path, init_args, GIT_TIMEOUT_LOCAL, NULL, 0) != 0) return -1;
+        
+        const char* settings[][2] = {
+            { "remote.origin.url", url },
+            { "remote.origin.fetch", "+refs/heads/*:refs/heads/*" },
+            { "fetch.prune", "false" },
+            { "gc.auto", "0" },
+            { "gc.pruneExpire", "never" },
+        };
+        for (size_t i = 0; i < sizeof(settings) / sizeof(settings[0]); i++) {
+            const char* config_args[] = { "-C", cache, "config", settings[i][0], settings[i][1], NULL };
+            if (run_git(log_path, config_args, GIT_TIMEOUT_LOCAL, NULL, 0) != 0) return -1;
+        }
+    }
+    
+    const char* fetch_args[] = { "-C", cache, "fetch", "--quiet", "origin", NULL };
+    return run_git(log_path, fetch_args, git_network_timeout, NULL, 0);
+}
+
+/*
+ * Point a clone at the cache through objects/info/alternates and repack
+ * it without the objects the cache provides. Local-only objects (unpushed
+ * commits, stashes) stay in the clone. repack only deletes old packs once
+ * the new one is written, so if it fails the clone is intact and the
+ * alternates entry is withdrawn again (-1). Once repack succeeded the
+ * clone depends on the cache, so a failed fsck afterwards leaves it linked
+ * and returns -2.
+ */
+static int link_shared_objects(const char* path, const char* cache) {
+    char alternates[MAX_PATH_LEN + 64];
+    char tmp_path[MAX_PATH_LEN + 80];
+    
+    snprintf(alternates, sizeof(alternates), "%s/.git/objects/info", path);
+    mkdir(alternates, 0755);
+    snprintf(alternates, sizeof(alternates), "%s/.git/objects/info/alternates", path);
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", alternates);
+    
+    FILE* fp = fopen(tmp_path, "w");
+    if (!fp) return -1;
+    fprintf(fp, "%s/objects\n", cache);
+    if (fclose(fp) != 0 || rename(tmp_path, alternates) != 0) {
+        unlink(tmp_path);
+        return -1;
+    }
+    
+    const char* repack_args[] = { "repack", "-a", "-d", "-l", "-q", NULL };
+    if (run_git(path, repack_args, GIT_TIMEOUT_MAINTENANCE, NULL, 0) != 0) {
+        unlink(alternates);
+        return -1;
+    }
+    
+    const char* fsck_args[] = { "fsck", "--connectivity-only", "--no-dangling", NULL };
+    return run_git(path, fsck_args, GIT_TIMEOUT_MAINTENANCE, NULL, 0) == 0 ? 0 : -2;
+}
+
+/*
+ * Group repositories by normalized remote URL and list groups with more
+ * than one clone. With link set, every group gets a shared bare cache in
+ * the gitsync data directory (objects/) that is fetched once, and each clone that passes
+ * share_objects_blocker() borrows its objects from it.
+ */
+static int run_clone_groups(int link) {
+    int groups = 0, linked = 0, failed = 0;
+    long saved_kib = 0;
+    
+    int* order = malloc(sizeof(int) * (size_t)repo_count);
+    group_keys = malloc(sizeof(*group_keys) * (size_t)repo_count);
+    if (!order || !group_keys) {
+        free(order);
+        free(group_keys);
+        show_error("Out of memory");
+        return 1;
+    }
+    
+    for (int i = 0; i < repo_count; i++) {
+        get_remote_url(repos[i].path, repos[i].remote, sizeof(repos[i].remote));
+        if (strcmp(repos[i].remote, "No remote") == 0) {
+            group_keys[i][0] = '\0';
+        } else {
+            normalize_remote_url(repos[i].remote, group_keys[i], sizeof(group_keys[i]));
+        }
+        order[i] = i;
+    }
+    qsort(order, (size_t)repo_count, sizeof(order[0]), compare_group_keys);
+    
+    for (int start = 0; start < repo_count; ) {
+        int end = start + 1;
+        while (end < repo_count && strcmp(group_keys[order[end]], group_keys[order[start]]) == 0) end++;
+        
+        const char* key = group_keys[order[start]];
+        if (!key[0] || end - start < 2) {
+            start = end;
+            continue;
+        }
+        groups++;
+        
+        // One cache per remote: readable name plus a hash of the full key
+        unsigned long long hash = 14695981039346656037ULL;
+        for (const char* p = key; *p; p++) hash = (hash ^ (unsigned char)*p) * 1099511628211ULL;
+        const char* base = strrchr(key, '/');
+        char name[MAX_PATH_LEN];
+        char cache[MAX_PATH_LEN];
+        snprintf(name, sizeof(name), "objects/%.64s-%016llx.git", base ? base + 1 : key, hash);
+        int cache_ok = gitsync_data_path(cache, sizeof(cache), "objects") == 0;
+        if (cache_ok) {
+            mkdir(cache, 0755);
+            cache_ok = gitsync_data_path(cache, sizeof(cache), name) == 0;
+        }
+        
+        printf("\n%s[%s]%s %s %s(%d clones)%s\n", COLOR_BLUE, "GROUP", COLOR_RESET, key, COLOR_DIM, end - start, COLOR_RESET);
+        
+        int cache_ready = 0;
+        if (link && !cache_ok) {
+            show_error("Shared cache path is too long; group skipped");
+        } else if (link) {
+            const char* url = repos[order[start]].remote;
+            start_loading("Fetching shared cache...");
+            int result = prepare_shared_cache(cache, url, repos[order[start]].path);
+            stop_loading();
+            if (result == 0) {
+                printf(" done\n");
+                cache_ready = 1;
+            } else {
+                printf(" failed\n");
+                print_log_tail(repos[order[start]].path, SYNC_LOG_TAIL_LINES);
+                show_error("Could not fetch the shared cache; group skipped");
+            }
+        }
+        
+        for (int k = start; k < end; k++) {
+            const char* path = repos[order[k]].path;
+            char current[MAX_PATH_LEN];
+            long before = packed_size_kib(path);
+            
+            if (shared_cache_of(path, current, sizeof(current)) && strcmp(current, cache) == 0) {
+                printf("  %s %s(shared, %ld KiB local)%s\n", path, COLOR_GREEN, before, COLOR_RESET);
+                continue;
+            }
+            
+            const char* blocker = share_objects_blocker(path);
+            if (blocker) {
+                printf("  %s %s(skipped: %s)%s\n", path, COLOR_YELLOW, blocker, COLOR_RESET);
+                continue;
+            }
+            if (!cache_ready) {
+                printf("  %s %s(%ld KiB)%s\n", path, COLOR_DIM, before, COLOR_RESET);
+                continue;
+            }
+            
+            int result = link_shared_objects(path, cache);
+            if (result == 0) {
+                long after = packed_size_kib(path);
+                printf("  %s %s(linked, %ld -> %ld KiB)%s\n", path, COLOR_GREEN, before, after, COLOR_RESET);
+                if (before > after && after >= 0) saved_kib += before - after;
+                linked++;
+            } else if (result == -2) {
+                printf("  %s %s(linked, but fsck failed - run git fsck there; do not remove the cache)%s\n",
+                       path, COLOR_RED, COLOR_RESET);
+                print_log_tail(path, SYNC_LOG_TAIL_LINES);
+                failed++;
+            } else {
+                printf("  %s %s(link failed)%s\n", path, COLOR_RED, COLOR_RESET);
+                print_log_tail(path, SYNC_LOG_TAIL_LINES);
+                failed++;
+            }
+        }
+        start = end;
+    }
+    free(order);
+    free(group_keys);
+    group_keys = NULL;
+    
+    printf("\n");
+    if (groups == 0) {
+        show_info("No repositories share a remote");
+    } else if (link) {
+        printf("%s[%s]%s %d clone groups, %d clones linked, %d failed, %ld KiB saved\n",
+               failed ? COLOR_YELLOW : COLOR_GREEN, "SUMMARY", COLOR_RESET, groups, linked, failed, saved_kib);
+    } else {
+        show_info("Run with --share-objects to link each group to a shared object cache");
+    }
+    return failed ? 1 : 0;
+}
+
+/* Write a label value with the escapes required by OpenMetrics */
+static void write_label_value(FILE* out, const char* value) {
+    for (const char* p = value; *p; p++) {
+        if (*p == '\\' || *p == '"') {
+            fputc('\\', out);
+            fputc(*p, out);
+        } else if (*p == '\n') {
+            fputs("\\n", out);
+        } else {
+            fputc(*p, out);
+        }
+    }
+}
+
+static void write_repo_sample(FILE* out, const char* metric, const Repository* repo, long value) {
+    fprintf(out, "%s{repo=\"", metric);
+    write_label_value(out, repo->name);
+    fputs("\",path=\"", out);
+    write_label_value(out, repo->path);
+    fprintf(out, "\"} %ld\n", value);
+}
+
+/*
+ * Render everything in OpenMetrics text format. Only cached probe results
+ * are used, so this never spawns git and stays linear in the repo count.
+ * Repositories that have not been probed yet, or whose fetch failed, are
+ * left out of the gauges they would otherwise report as 0.
+ */
+static void write_metrics(FILE* out) {
+    fputs("# TYPE gitsync_repo_dirty gauge\n"
+          "# HELP gitsync_repo_dirty Whether the worktree has uncommitted changes.\n", out);
+    for (int i = 0; i < repo_count; i++) {
+        if (repos[i].local_probed_at == 0) continue;
+        write_repo_sample(out, "gitsync_repo_dirty", &repos[i], repos[i].has_local_changes);
+    }
+    
+    fputs("# TYPE gitsync_repo_ahead gauge\n"
+          "# HELP gitsync_repo_ahead Commits on HEAD that are not on origin/main.\n", out);
+    for (int i = 0; i < repo_count; i++) {
+        if (repos[i].remote_probed_at == 0 || repos[i].ahead < 0) continue;
+        write_repo_sample(out, "gitsync_repo_ahead", &repos[i], repos[i].ahead);
+    }
+    
+    fputs("# TYPE gitsync_repo_behind gauge\n"
+          "# HELP gitsync_repo_behind Commits on origin/main that are not on HEAD.\n", out);
+    for (int i = 0; i < repo_count; i++) {
+        if (repos[i].remote_probed_at == 0 || repos[i].behind < 0) continue;
+        write_repo_sample(out, "gitsync_repo_behind", &repos[i], repos[i].behind);
+    }
+    
+    fputs("# TYPE gitsync_repo_last_sync_timestamp_seconds gauge\n"
+          "# HELP gitsync_repo_last_sync_timestamp_seconds Unix time of the last successful sync.\n", out);
+    for (int i = 0; i < repo_count; i++) {
+        if (repos[i].last_sync_at == 0) continue;
+        write_repo_sample(out, "gitsync_repo_last_sync_timestamp_seconds", &repos[i], (long)repos[i].last_sync_at);
+    }
+    
+    fputs("# TYPE gitsync_repo_last_sync_failure_timestamp_seconds gauge\n"
+          "# HELP gitsync_repo_last_sync_failure_timestamp_seconds Unix time of the last failed sync.\n", out);
+    for (int i = 0; i < repo_count; i++) {
+        if (repos[i].last_failure_at == 0) continue;
+        write_repo_sample(out, "gitsync_repo_last_sync_failure_timestamp_seconds", &repos[i], (long)repos[i].last_failure_at);
+    }
+    
+    fputs("# TYPE gitsync_repo_sync_failures gauge\n"
+          "# HELP gitsync_repo_sync_failures Failed syncs since the last successful one.\n", out);
+    for (int i = 0; i < repo_count; i++) {
+        if (repos[i].last_sync_at == 0 && repos[i].last_failure_at == 0) continue;
+        write_repo_sample(out, "gitsync_repo_sync_failures", &repos[i], repos[i].sync_failures);
+    }
+    
+    fputs("# TYPE gitsync_operation_duration_seconds histogram\n"
+          "# HELP gitsync_operation_duration_seconds Duration of scan, probe and sync steps.\n", out);
+    for (int op = 0; op < OP_COUNT; op++) {
+        const Histogram* h = &op_histograms[op];
+        unsigned long cumulative = 0;
+        
+        for (int b = 0; b < METRICS_BUCKETS; b++) {
+            cumulative += h->buckets[b];
+            fprintf(out, "gitsync_operation_duration_seconds_bucket{op=\"%s\",le=\"%g\"} %lu\n",
+                    metric_op_names[op], metrics_bounds[b], cumulative);
+        }
+        fprintf(out, "gitsync_operation_duration_seconds_bucket{op=\"%s\",le=\"+Inf\"} %lu\n",
+                metric_op_names[op], h->count);
+        fprintf(out, "gitsync_operation_duration_seconds_count{op=\"%s\"} %lu\n", metric_op_names[op], h->count);
+        fprintf(out, "gitsync_operation_duration_seconds_sum{op=\"%s\"} %.6f\n", metric_op_names[op], h->sum);
+    }
+    fputs("# EOF\n", out);
+}
+
+/* Replace the textfile atomically so a collector never reads a partial file */
+static int write_metrics_file(const char* file_path) {
+    char tmp_path[MAX_PATH_LEN + 32];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.%d.tmp", file_path, (int)getpid());
+    
+    FILE* out = fopen(tmp_path, "w");
+    if (!out) return -1;
+    
+    write_metrics(out);
+    if (fclose(out) != 0 || rename(tmp_path, file_path) != 0) {
+        unlink(tmp_path);
+        return -1;
+    }
+    return 0;
+}
+
+static int open_metrics_listener(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    
+    int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((unsigned short)port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, 8) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/* Wait up to timeout_ms for a scrape and answer at most one request */
+static void serve_metrics_request(int listen_fd, int timeout_ms) {
+    fd_set fds;
+    struct timeval tv;
+    
+    FD_ZERO(&fds);
+    FD_SET(listen_fd, &fds);
+    tv.tv_sec = timeout_ms / 1000;
+    tv.tv_usec = (timeout_ms % 1000) * 1000;
+    if (select(listen_fd + 1, &fds, NULL, NULL, &tv) <= 0) return;
+    
+    int client = accept(listen_fd, NULL, NULL);
+    if (client < 0) return;
+    
+    struct timeval recv_timeout = { 1, 0 };
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &recv_timeout, sizeof(recv_timeout));
+    
+    char request[512];
+    ssize_t n = read(client, request, sizeof(request) - 1);
+    request[n > 0 ? n : 0] = '\0';
+    
+    char* body = NULL;
+    size_t body_len = 0;
+    FILE* out = open_memstream(&body, &body_len);
+    if (out) {
+        int found = strncmp(request, "GET /metrics", 12) == 0;
+        if (found) write_metrics(out);
+        fclose(out);
+        
+        char header[256];
+        int header_len = snprintf(header, sizeof(header),
+            "HTTP/1.0 %s\r\n"
+            "Content-Type: application/openmetrics-text; version=1.0.0; charset=utf-8\r\n"
+            "Content-Length: %zu\r\n\r\n",
+            found ? "200 OK" : "404 Not Found", body_len);
+        if (write(client, header, (size_t)header_len) == header_len && body_len > 0) {
+            ssize_t written = write(client, body, body_len);
+            (void)written;
+        }
+        free(body);
+    }
+    close(client);
+}
+
+/*
+ * fsmonitor provider. Repositories opted in with --fsmonitor-install run
+ * `gitsync --fsmonitor-query` as their core.fsmonitor hook. In watch mode
+ * gitsync keeps an inotify watch on every worktree directory of those
+ * repositories and appends each touched path to .git/gitsync-fsmonitor:
+ *
+ *     gitsync-fsmonitor <instance>\n
+ *     <path relative to the worktree>\n ...   ("/" = everything changed)
+ *
+ * A token is "gitsync:<instance>:<offset>", so a query just returns the
+ * lines past offset. The daemon holds an exclusive flock on the journal;
+ * if the lock is free, nobody is recording events and the query answers
+ * "/" so git falls back to a full scan.
+ */
+static const char* fsmonitor_token_prefix = "gitsync:";
+
+/* Answer when the journal cannot be trusted: a fresh token plus "/" */
+static int fsmonitor_answer_all(const char* instance, long offset) {
+    printf("%s%s:%ld", fsmonitor_token_prefix, instance, offset);
+    fputc('\0', stdout);
+    fputs("/", stdout);
+    fputc('\0', stdout);
+    return 0;
+}
+
+/*
+ * Wait until the daemon has consumed every event queued before this
+ * query: create a cookie file in .git and wait for the daemon, which
+ * handles inotify events in order, to flush the journal and delete it.
+ */
+static int fsmonitor_sync_cookie(void) {
+    char cookie[64];
+    snprintf(cookie, sizeof(cookie), ".git/%s%d", FSMONITOR_COOKIE_PREFIX, (int)getpid());
+    
+    int fd = open(cookie, O_CREAT | O_WRONLY | O_EXCL, 0644);
+    if (fd < 0) return -1;
+    close(fd);
+    
+    double deadline = monotonic_seconds() + FSMONITOR_COOKIE_MS / 1000.0;
+    struct stat st;
+    while (stat(cookie, &st) == 0) {
+        if (monotonic_seconds() >= deadline) {
+            unlink(cookie);
+            return -1;
+        }
+        struct timespec ts = { 0, 500000 };
+        nanosleep(&ts, NULL);
+    }
+    return 0;
+}
+
+/* `gitsync --fsmonitor-query VERSION TOKEN`, run by git in the worktree root */
+static int run_fsmonitor_query(int version, const char* token) {
+    if (version != 2) return 1;  // Git falls back to a full scan
+    
+    FILE* fp = fopen(".git/" FSMONITOR_JOURNAL, "r");
+    if (!fp) return fsmonitor_answer_all("none", 0);
+    
+    // A free lock means no daemon is recording events
+    if (flock(fileno(fp), LOCK_SH | LOCK_NB) == 0) {
+        fclose(fp);
+        return fsmonitor_answer_all("none", 0);
+    }
+    
+    if (!getenv("GITSYNC_FSMONITOR_SYNCED") && fsmonitor_sync_cookie() != 0) {
+        fclose(fp);
+        return fsmonitor_answer_all("none", 0);
+    }
+    
+    char header[128];
+    char instance[64];
+    if (!fgets(header, sizeof(header), fp) || sscanf(header, "gitsync-fsmonitor %63s", instance) != 1) {
+        fclose(fp);
+        return fsmonitor_answer_all("none", 0);
+    }
+    long header_end = ftell(fp);
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    
+    // Only complete lines count; the daemon may be mid-write
+    long end = size;
+    while (end > header_end) {
+        char ch;
+        fseek(fp, end - 1, SEEK_SET);
+        if (fread(&ch, 1, 1, fp) == 1 && ch == '\n') break;
+        end--;
+    }
+    
+    size_t prefix_len = strlen(fsmonitor_token_prefix);
+    size_t instance_len = strlen(instance);
+    long offset = -1;
+    if (strncmp(token, fsmonitor_token_prefix, prefix_len) == 0 &&
+        strncmp(token + prefix_len, instance, instance_len) == 0 &&
+        token[prefix_len + instance_len] == ':') {
+        offset = atol(token + prefix_len + instance_len + 1);
+    }
+    if (offset < header_end || offset > end) {
+        fclose(fp);
+        return fsmonitor_answer_all(instance, end);
+    }
+    
+    printf("%s%s:%ld", fsmonitor_token_prefix, instance, end);
+    fputc('\0', stdout);
+    
+    char path[MAX_PATH_LEN * 2];
+    fseek(fp, offset, SEEK_SET);
+    while (ftell(fp) < end && fgets(path, sizeof(path), fp)) {
+        path[strcspn(path, "\n")] = '\0';
+        fputs(path, stdout);
+        fputc('\0', stdout);
+    }
+    fclose(fp);
+    return 0;
+}
+
+/* The command written to core.fsmonitor: this binary, quoted for the shell */
+static int fsmonitor_hook_command(char* buffer, size_t size) {
+    char exe[MAX_PATH_LEN];
+    ssize_t len = readlink("/proc/self/exe", exe, sizeof(exe) - 1);
+    if (len <= 0) return -1;
+    exe[len] = '\0';
+    if (strchr(exe, '\'')) return -1;
+    
+    snprintf(buffer, size, "'%s' --fsmonitor-query", exe);
+    return 0;
+}
+
+/* Settings --fsmonitor-install changes, and where it keeps their previous values */
+static const char* fsmonitor_settings[][2] = {
+    { "core.fsmonitor", "gitsync.savedFsmonitor" },
+    { "core.fsmonitorHookVersion", "gitsync.savedFsmonitorHookVersion" },
+    { "core.untrackedCache", "gitsync.savedUntrackedCache" },
+};
+#define FSMONITOR_SETTINGS (sizeof(fsmonitor_settings) / sizeof(fsmonitor_settings[0]))
+
+/* Value of a key in the repository's own config; returns -1 if it is not set there */
+static int fsmonitor_config_get(const char* path, const char* key, char* value, size_t size) {
+    const char* args[] = { "config", "--local", "--get", key, NULL };
+    if (run_git(path, args, GIT_TIMEOUT_LOCAL, value, size) != 0) return -1;
+    value[strcspn(value, "\n")] = '\0';
+    return 0;
+}
+
+static int fsmonitor_installed(const char* path) {
+    const char* args[] = { "config", "--local", "--get", "core.fsmonitor", NULL };
+    char value[MAX_PATH_LEN + 64];
+    return run_git(path, args, GIT_TIMEOUT_LOCAL, value, sizeof(value)) == 0 &&
+           strstr(value, "--fsmonitor-query") != NULL;
+}
+
+/*
+ * Opt the scanned repositories in to (or out of) the gitsync fsmonitor
+ * hook. The first install saves any previous value of the settings it
+ * changes under gitsync.saved*, and uninstall puts them back.
+ */
+static int run_fsmonitor_install(int install) {
+    char hook[MAX_PATH_LEN + 64];
+    int failed = 0;
+    
+    if (install && fsmonitor_hook_command(hook, sizeof(hook)) != 0) {
+        show_error("Could not determine the path of this gitsync binary");
+        return 1;
+    }
+    
+    for (int i = 0; i < repo_count; i++) {
+        const char* path = repos[i].path;
+        int result = 0;
+        
+        char value[MAX_PATH_LEN + 64];
+        
+        if (install) {
+            const char* values[FSMONITOR_SETTINGS] = { hook, "2", "true" };
+            int reinstall = fsmonitor_installed(path);
+            
+            for (size_t k = 0; k < FSMONITOR_SETTINGS && result == 0; k++) {
+                // Keep what was there before the first install, for --fsmonitor-uninstall
+                if (!reinstall && fsmonitor_config_get(path, fsmonitor_settings[k][0], value, sizeof(value)) == 0) {
+                    const char* save_args[] = { "config", fsmonitor_settings[k][1], value, NULL };
+                    result = run_git(path, save_args, GIT_TIMEOUT_LOCAL, NULL, 0);
+                    if (result != 0) break;
+                }
+                const char* args[] = { "config", fsmonitor_settings[k][0], values[k], NULL };
+                result = run_git(path, args, GIT_TIMEOUT_LOCAL, NULL, 0);
+            }
+        } else if (fsmonitor_installed(path)) {
+            char journal_path[MAX_PATH_LEN + 32];
+            
+            // Restore the saved values; settings that were unset before are unset again
+            for (size_t k = 0; k < FSMONITOR_SETTINGS && result == 0; k++) {
+                if (fsmonitor_config_get(path, fsmonitor_settings[k][1], value, sizeof(value)) == 0) {
+                    const char* restore_args[] = { "config", fsmonitor_settings[k][0], value, NULL };
+                    const char* unset_saved[] = { "config", "--unset", fsmonitor_settings[k][1], NULL };
+                    result = run_git(path, restore_args, GIT_TIMEOUT_LOCAL, NULL, 0);
+                    if (result == 0) run_git(path, unset_saved, GIT_TIMEOUT_LOCAL, NULL, 0);
+                } else if (fsmonitor_config_get(path, fsmonitor_settings[k][0], value, sizeof(value)) == 0) {
+                    const char* unset_args[] = { "config", "--unset", fsmonitor_settings[k][0], NULL };
+                    result = run_git(path, unset_args, GIT_TIMEOUT_LOCAL, NULL, 0);
+                }
+            }
+            snprintf(journal_path, sizeof(journal_path), "%s/.git/%s", path, FSMONITOR_JOURNAL);
+            unlink(journal_path);
+        } else {
+            continue;
+        }
+        
+        if (result == 0) {
+            printf("  %s %s(%s)%s\n", path, COLOR_GREEN, install ? "installed" : "removed", COLOR_RESET);
+        } else {
+            printf("  %s %s(failed)%s\n", path, COLOR_RED, COLOR_RESET);
+            print_log_tail(path, SYNC_LOG_TAIL_LINES);
+            failed++;
+        }
+    }
+    
+    if (install && !failed) {
+        show_info("Run gitsync --watch on these repositories to serve fsmonitor queries");
+    }
+    return failed ? 1 : 0;
+}
+
+#ifdef __linux__
+
+typedef struct {
+    int repo;                   // Index into repos[], -1 for a free slot
+    int is_git_dir;             // The .git directory itself, watched for cookies
+    char* rel;                  // Directory relative to the worktree, "" for the root
+} FsWatch;
+
+typedef struct {
+    FILE* fp;                   // Journal, flocked while we record; NULL when off
+    char instance[64];
+    int generation;
+    char last[MAX_PATH_LEN];    // Last path written, to skip event bursts
+} FsJournal;
+
+static FsWatch* fs_watches;     // Indexed by inotify watch descriptor
+static int fs_watch_cap = 0;
+static FsJournal* fs_journals;   // One per repository once serving starts
+
+static void fsmonitor_journal_reset(int repo) {
+    FsJournal* journal = &fs_journals[repo];
+    
+    snprintf(journal->instance, sizeof(journal->instance), "%d-%ld-%d",
+             (int)getpid(), (long)time(NULL), journal->generation++);
+    if (ftruncate(fileno(journal->fp), 0) != 0) {
+        // Closing drops the lock, so queries fall back to full scans
+        fclose(journal->fp);
+        journal->fp = NULL;
+        return;
+    }
+    rewind(journal->fp);
+    fprintf(journal->fp, "gitsync-fsmonitor %s\n", journal->instance);
+    fflush(journal->fp);
+    journal->last[0] = '\0';
+}
+
+static void fsmonitor_record(int repo, const char* rel, int is_dir) {
+    FsJournal* journal = &fs_journals[repo];
+    if (!journal->fp) return;
+    
+    // Names with newlines cannot be journaled; invalidate everything instead
+    if (strchr(rel, '\n')) rel = "/";
+    if (strcmp(rel, journal->last) == 0) return;
+    snprintf(journal->last, sizeof(journal->last), "%s", rel);
+    fprintf(journal->fp, "%s%s\n", rel, is_dir && strcmp(rel, "/") != 0 ? "/" : "");
+}
+
+static int fsmonitor_add_watch(int repo, const char* rel, int is_git_dir) {
+    char dir_path[MAX_PATH_LEN * 2];
+    if (is_git_dir) {
+        snprintf(dir_path, sizeof(dir_path), "%s/.git", repos[repo].path);
+    } else {
+        snprintf(dir_path, sizeof(dir_path), "%s%s%s", repos[repo].path, rel[0] ? "/" : "", rel);
+    }
+    
+    uint32_t mask = is_git_dir ? IN_CREATE
+        : IN_CREATE | IN_DELETE | IN_MODIFY | IN_ATTRIB | IN_MOVED_FROM | IN_MOVED_TO | IN_CLOSE_WRITE | IN_ONLYDIR;
+    int wd = inotify_add_watch(fsmonitor_inotify_fd, dir_path, mask);
+    if (wd < 0) return -1;
+    
+    if (wd >= fs_watch_cap) {
+        int cap = fs_watch_cap ? fs_watch_cap : 256;
+        while (cap <= wd) cap *= 2;
+        FsWatch* grown = realloc(fs_watches, sizeof(FsWatch) * (size_t)cap);
+        if (!grown) return -1;
+        for (int i = fs_watch_cap; i < cap; i++) {
+            grown[i].repo = -1;
+            grown[i].rel = NULL;
+        }
+        fs_watches = grown;
+        fs_watch_cap = cap;
+    }
+    
+    free(fs_watches[wd].rel);
+    fs_watches[wd].repo = repo;
+    fs_watches[wd].is_git_dir = is_git_dir;
+    fs_watches[wd].rel = strdup(rel);
+    return 0;
+}
+
+/* Watch rel and every directory below it, skipping nested .git directories */
+static int fsmonitor_add_tree(int repo, const char* rel) {
+    if (fsmonitor_add_watch(repo, rel, 0) != 0) return -1;
+    
+    char dir_path[MAX_PATH_LEN * 2];
+    snprintf(dir_path, sizeof(dir_path), "%s%s%s", repos[repo].path, rel[0] ? "/" : "", rel);
+    DIR* dir = opendir(dir_path);
+    if (!dir) return 0;
+    
+    int result = 0;
+    struct dirent* entry;
+    while (result == 0 && (entry = readdir(dir)) != NULL) {
+        if (entry->d_type != DT_DIR || strcmp(entry->d_name, ".") == 0 ||
+            strcmp(entry->d_name, "..") == 0 || strcmp(entry->d_name, ".git") == 0) {
+            continue;
+        }
+        char child[MAX_PATH_LEN];
+        snprintf(child, sizeof(child), "%s%s%s", rel, rel[0] ? "/" : "", entry->d_name);
+        result = fsmonitor_add_tree(repo, child);
+    }
+    closedir(dir);
+    return result;
+}
+
+/* Drop every watch of a repository that cannot be served, freeing them for the others */
+static void fsmonitor_remove_watches(int repo) {
+    for (int wd = 0; wd < fs_watch_cap; wd++) {
+        if (fs_watches[wd].repo != repo) continue;
+        inotify_rm_watch(fsmonitor_inotify_fd, wd);
+        free(fs_watches[wd].rel);
+        fs_watches[wd].rel = NULL;
+        fs_watches[wd].repo = -1;
+    }
+}
+
+/*
+ * Start recording events for one repository. The journal is locked and
+ * emptied first (so a repository another gitsync serves is not watched
+ * twice) but only initialized once every directory is watched: while the
+ * header is missing, queries answer "/", so a partially watched worktree (for
+ * example after hitting fs.inotify.max_user_watches) is never trusted.
+ */
+static int fsmonitor_start(int repo) {
+    char journal_path[MAX_PATH_LEN + 32];
+    snprintf(journal_path, sizeof(journal_path), "%s/.git/%s", repos[repo].path, FSMONITOR_JOURNAL);
+    
+    FILE* fp = fopen(journal_path, "a+e");
+    if (!fp) return -1;
+    if (flock(fileno(fp), LOCK_EX | LOCK_NB) != 0) {
+        fclose(fp);
+        return -1;  // Another gitsync already serves this repository
+    }
+    // A previous daemon's records must not be trusted while we catch up
+    if (ftruncate(fileno(fp), 0) != 0) {
+        fclose(fp);
+        return -1;
+    }
+    
+    if (fsmonitor_add_tree(repo, "") != 0 || fsmonitor_add_watch(repo, "", 1) != 0) {
+        fsmonitor_remove_watches(repo);
+        fclose(fp);
+        return -1;
+    }
+    
+    fs_journals[repo].fp = fp;
+    fsmonitor_journal_reset(repo);
+    return 0;
+}
+
+/* Watch-mode setup: serve every repository that installed the hook */
+static void fsmonitor_start_all(void) {
+    int serving = 0;
+    
+    for (int i = 0; i < repo_count; i++) {
+        if (!fsmonitor_installed(repos[i].path)) continue;
+        
+        if (!fs_journals) {
+            fs_journals = calloc((size_t)repo_count, sizeof(FsJournal));
+            if (!fs_journals) return;
+        }
+        if (fsmonitor_inotify_fd < 0) {
+            fsmonitor_inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+            if (fsmonitor_inotify_fd < 0) {
+                show_warning("inotify unavailable; fsmonitor queries will fall back to full scans");
+                return;
+            }
+        }
+        
+        if (fsmonitor_start(i) == 0) {
+            serving++;
+        } else {
+            printf("%s[%s]%s fsmonitor not served for %s (watch limit or already served)\n",
+                   COLOR_YELLOW, "WARN", COLOR_RESET, repos[i].path);
+        }
+    }
+    
+    if (serving > 0) {
+        printf("%s[%s]%s Serving fsmonitor for %d repositor%s\n",
+               COLOR_BLUE, "INFO", COLOR_RESET, serving, serving == 1 ? "y" : "ies");
+    }
+}
+
+/* Journal every queued inotify event, then acknowledge sync cookies */
+static void fsmonitor_process_events(void) {
+    char buffer[65536] __attribute__((aligned(__alignof__(struct inotify_event))));
+    ssize_t n;
+    
+    while ((n = read(fsmonitor_inotify_fd, buffer, sizeof(buffer))) > 0) {
+        for (char* p = buffer; p < buffer + n; ) {
+            struct inotify_event* event = (struct inotify_event*)p;
+            p += sizeof(struct inotify_event) + event->len;
+            
+            if (event->mask & IN_Q_OVERFLOW) {
+                for (int i = 0; i < repo_count; i++) fsmonitor_record(i, "/", 0);
+                continue;
+            }
+            if (event->wd < 0 || event->wd >= fs_watch_cap || fs_watches[event->wd].repo < 0) continue;
+            
+            FsWatch* watch = &fs_watches[event->wd];
+            int repo = watch->repo;
+            
+            if (event->mask & IN_IGNORED) {
+                free(watch->rel);
+                watch->rel = NULL;
+                watch->repo = -1;
+                continue;
+            }
+            
+            if (watch->is_git_dir) {
+                if (event->len && strncmp(event->name, FSMONITOR_COOKIE_PREFIX, strlen(FSMONITOR_COOKIE_PREFIX)) == 0) {
+                    char cookie[MAX_PATH_LEN * 2];
+                    fflush(fs_journals[repo].fp);
+                    snprintf(cookie, sizeof(cookie), "%s/.git/%s", repos[repo].path, event->name);
+                    unlink(cookie);
+                }
+                continue;
+            }
+            
+            char rel[MAX_PATH_LEN];
+            if (event->len) {
+                snprintf(rel, sizeof(rel), "%s%s%s", watch->rel, watch->rel[0] ? "/" : "", event->name);
+            } else {
+                snprintf(rel, sizeof(rel), "%s", watch->rel[0] ? watch->rel : "/");
+            }
+            
+            int is_dir = (event->mask & IN_ISDIR) != 0;
+            if (is_dir && (event->mask & (IN_CREATE | IN_MOVED_TO)) && strcmp(event->name, ".git") != 0) {
+                if (fsmonitor_add_tree(repo, rel) != 0) {
+                    fsmonitor_record(repo, "/", 0);
+                }
+            }
+            fsmonitor_record(repo, rel, is_dir);
+        }
+    }
+    
+    for (int i = 0; i < repo_count; i++) {
+        FsJournal* journal = &fs_journals[i];
+        if (!journal->fp) continue;
+        fflush(journal->fp);
+        if (ftell(journal->fp) > FSMONITOR_JOURNAL_MAX) fsmonitor_journal_reset(i);
+    }
+}
+
+#else
+
+static void fsmonitor_start_all(void) {
+    for (int i = 0; i < repo_count; i++) {
+        if (fsmonitor_installed(repos[i].path)) {
+            show_warning("fsmonitor serving needs inotify (Linux); queries will fall back to full scans");
+            return;
+        }
+    }
+}
+
+static void fsmonitor_process_events(void) {
+}
+
+#endif
+
+/* Add the metrics listener and inotify fd to a select() set, returning the new max fd */
+static int add_service_fds(fd_set* fds, int max_fd) {
+    if (metrics_listen_fd >= 0) {
+        FD_SET(metrics_listen_fd, fds);
+        if (metrics_listen_fd > max_fd) max_fd = metrics_listen_fd;
+    }
+    if (fsmonitor_inotify_fd >= 0) {
+        FD_SET(fsmonitor_inotify_fd, fds);
+        if (fsmonitor_inotify_fd > max_fd) max_fd = fsmonitor_inotify_fd;
+    }
+    return max_fd;
+}
+
+/*
+ * Journal pending fsmonitor events (acknowledging sync cookies) and answer
+ * a pending scrape. Called from every select() in watch mode, including
+ * run_git()'s, so a slow fetch never holds up /metrics or a git status
+ * waiting on its cookie.
+ */
+static void service_fds(const fd_set* fds) {
+    if (fsmonitor_inotify_fd >= 0 && FD_ISSET(fsmonitor_inotify_fd, fds)) fsmonitor_process_events();
+    if (metrics_listen_fd >= 0 && FD_ISSET(metrics_listen_fd, fds)) serve_metrics_request(metrics_listen_fd, 0);
+}
+
+/* Sleep up to timeout_ms in watch mode while servicing service_fds() */
+static void watch_wait(int timeout_ms) {
+    fd_set fds;
+    
+    FD_ZERO(&fds);
+    int max_fd = add_service_fds(&fds, -1);
+    
+    struct timeval tv = { timeout_ms / 1000, (timeout_ms % 1000) * 1000 };
+    if (select(max_fd + 1, &fds, NULL, NULL, &tv) <= 0) return;
+    service_fds(&fds);
+}
+
+/*
+ * Watch mode: keep probe results fresh and export them, without ever
+ * syncing. Probes respect the usual TTLs, so short intervals only re-probe
+ * what went stale; scrapes are answered while git runs as well. Sync
+ * results are re-read from the state file every cycle, so syncs done by
+ * other gitsync runs show up in the metrics.
+ */
+static void run_watch(const ProgramConfig* config) {
+    if (config->metrics_port > 0) {
+        metrics_listen_fd = open_metrics_listener(config->metrics_port);
+        if (metrics_listen_fd < 0) {
+            show_error("Could not listen on metrics port");
+            return;
+        }
+        signal(SIGPIPE, SIG_IGN);
+        printf("%s[%s]%s Serving metrics on http://127.0.0.1:%d/metrics\n",
+               COLOR_BLUE, "INFO", COLOR_RESET, config->metrics_port);
+    }
+    
+    fsmonitor_start_all();
+    
+    for (int cycle = 0; config->watch_cycles == 0 || cycle < config->watch_cycles; cycle++) {
+        double deadline = monotonic_seconds() + config->watch_interval;
+        
+        for (int i = 0; i < repo_count; i++) {
+            // Drain events first so our own git status can trust the journal
+            watch_wait(0);
+            probe_repo(&repos[i], 1);
+        }
+        state_load(0);
+        
+        if (config->metrics_file && write_metrics_file(config->metrics_file) != 0) {
+            show_warning("Could not write metrics file");
+        }
+        
+        double remaining;
+        while ((remaining = deadline - monotonic_seconds()) > 0) {
+            watch_wait((int)(remaining * 1000) + 1);
+        }
+    }
+    
+    if (metrics_listen_fd >= 0) close(metrics_listen_fd);
+    metrics_listen_fd = -1;
 }
 
 static void parse_arguments(int argc, char* argv[], ProgramConfig* config) {
@@ -713,6 +3058,19 @@ static void parse_arguments(int argc, char* argv[], ProgramConfig* config) {
     config->commit_mode = COMMIT_MANUAL;
     config->show_help = 0;
     config->show_version = 0;
+    config->metrics_file = NULL;
+    config->metrics_port = 0;
+    config->watch_interval = -1;
+    config->watch_cycles = 0;
+    config->sync_all = 0;
+    config->journal_path = NULL;
+    config->git_timeout = GIT_TIMEOUT_NETWORK;
+    config->log_dir = NULL;
+    config->clone_groups = 0;
+    config->fsmonitor_install = 0;
+    config->fsmonitor_query = 0;
+    config->fsmonitor_version = 0;
+    config->fsmonitor_token = "";
     
     for (int i = 1; i < argc; i++) {
         if (strcmp(argv[i], "--date-commit") == 0) {
@@ -740,6 +3098,51 @@ static void parse_arguments(int argc, char* argv[], ProgramConfig* config) {
                 }
                 i++;
             }
+        } else if (strcmp(argv[i], "--metrics-file") == 0) {
+            if (i + 1 < argc) {
+                config->metrics_file = argv[++i];
+            }
+        } else if (strcmp(argv[i], "--metrics-port") == 0) {
+            if (i + 1 < argc) {
+                config->metrics_port = atoi(argv[++i]);
+            }
+        } else if (strcmp(argv[i], "--watch") == 0) {
+            if (i + 1 < argc) {
+                config->watch_interval = atoi(argv[++i]);
+                if (config->watch_interval < 0) config->watch_interval = 0;
+            }
+        } else if (strcmp(argv[i], "--cycles") == 0) {
+            if (i + 1 < argc) {
+                config->watch_cycles = atoi(argv[++i]);
+            }
+        } else if (strcmp(argv[i], "--sync-all") == 0) {
+            config->sync_all = 1;
+        } else if (strcmp(argv[i], "--journal") == 0) {
+            if (i + 1 < argc) {
+                config->journal_path = argv[++i];
+            }
+        } else if (strcmp(argv[i], "--timeout") == 0) {
+            if (i + 1 < argc) {
+                config->git_timeout = atoi(argv[++i]);
+                if (config->git_timeout < 1) config->git_timeout = 1;
+            }
+        } else if (strcmp(argv[i], "--log-dir") == 0) {
+            if (i + 1 < argc) {
+                config->log_dir = argv[++i];
+            }
+        } else if (strcmp(argv[i], "--clone-groups") == 0) {
+            if (config->clone_groups < 1) config->clone_groups = 1;
+        } else if (strcmp(argv[i], "--share-objects") == 0) {
+            config->clone_groups = 2;
+        } else if (strcmp(argv[i], "--fsmonitor-install") == 0) {
+            config->fsmonitor_install = 1;
+        } else if (strcmp(argv[i], "--fsmonitor-uninstall") == 0) {
+            config->fsmonitor_install = -1;
+        } else if (strcmp(argv[i], "--fsmonitor-query") == 0) {
+            // Hook protocol: VERSION TOKEN, the token may be empty
+            config->fsmonitor_query = 1;
+            if (i + 1 < argc) config->fsmonitor_version = atoi(argv[++i]);
+            if (i + 1 < argc) config->fsmonitor_token = argv[++i];
         } else if (strcmp(argv[i], "--tui") == 0) {
             config->mode = MODE_TUI;
         } else if (strcmp(argv[i], "--simple") == 0) {
@@ -775,6 +3178,18 @@ static void print_help(const char* program_name) {
     printf("  %s--version, -v%s      Show version\n", COLOR_CYAN, COLOR_RESET);
     printf("  %s--interface MODE%s    Interface mode: auto, simple, tui (default: auto)\n", COLOR_CYAN, COLOR_RESET);
     printf("  %s--commit-mode MODE%s  Commit mode: date, manual, prompt (default: manual)\n", COLOR_CYAN, COLOR_RESET);
+    printf("  %s--sync-all%s          Sync every repository found, resuming an interrupted run\n", COLOR_CYAN, COLOR_RESET);
+    printf("  %s--journal PATH%s      Sync journal (default: ~/.local/share/gitsync/sync.journal)\n", COLOR_CYAN, COLOR_RESET);
+    printf("  %s--timeout SECONDS%s   Deadline for fetch, pull and push (default: %d)\n", COLOR_CYAN, COLOR_RESET, GIT_TIMEOUT_NETWORK);
+    printf("  %s--log-dir DIR%s       Also append each repository's git output to DIR\n", COLOR_CYAN, COLOR_RESET);
+    printf("  %s--clone-groups%s      List clones that share a remote URL\n", COLOR_CYAN, COLOR_RESET);
+    printf("  %s--share-objects%s     Link each clone group to one shared object cache\n", COLOR_CYAN, COLOR_RESET);
+    printf("  %s--fsmonitor-install%s Use gitsync as core.fsmonitor for the repositories found\n", COLOR_CYAN, COLOR_RESET);
+    printf("  %s--fsmonitor-uninstall%s Remove the gitsync core.fsmonitor hook\n", COLOR_CYAN, COLOR_RESET);
+    printf("  %s--watch SECONDS%s     Re-probe repositories every SECONDS without syncing\n", COLOR_CYAN, COLOR_RESET);
+    printf("  %s--cycles N%s          Stop watch mode after N cycles (default: run forever)\n", COLOR_CYAN, COLOR_RESET);
+    printf("  %s--metrics-file PATH%s Write OpenMetrics text (node-exporter textfile)\n", COLOR_CYAN, COLOR_RESET);
+    printf("  %s--metrics-port PORT%s Serve /metrics on 127.0.0.1:PORT in watch mode\n", COLOR_CYAN, COLOR_RESET);
     printf("\n");
     
     printf("%sTUI Controls:%s\n", COLOR_YELLOW, COLOR_RESET);
@@ -782,6 +3197,9 @@ static void print_help(const char* program_name) {
     printf("  %senter%s              Select repository\n", COLOR_CYAN, COLOR_RESET);
     printf("  %sType letters%s        Filter repositories\n", COLOR_CYAN, COLOR_RESET);
     printf("  %sbackspace%s          Clear filter character\n", COLOR_CYAN, COLOR_RESET);
+    printf("  %sctrl+r%s             Re-probe selected repository (incl. fetch)\n", COLOR_CYAN, COLOR_RESET);
+    printf("  %sesc%s                Cancel the running git operation\n", COLOR_CYAN, COLOR_RESET);
+    printf("  %stab%s                Toggle git output log for the selected repository\n", COLOR_CYAN, COLOR_RESET);
     printf("  %sq%s                   Quit\n", COLOR_CYAN, COLOR_RESET);
     printf("  %sn%s                   Rescan repositories\n", COLOR_CYAN, COLOR_RESET);
     printf("\n");
@@ -790,6 +3208,10 @@ static void print_help(const char* program_name) {
     printf("  %s[✓]%s Clean - no changes\n", COLOR_GREEN, COLOR_RESET);
     printf("  %s[+]%s  Has local changes\n", COLOR_YELLOW, COLOR_RESET);
     printf("  %s[↓]%s  Has remote changes\n", COLOR_CYAN, COLOR_RESET);
+    printf("  %s[?]%s  Not probed yet\n", COLOR_DIM, COLOR_RESET);
+    printf("  %s[!]%s  Git timed out (unreachable remote, credential prompt)\n", COLOR_RED, COLOR_RESET);
+    printf("  %s[x]%s  Probe cancelled with Esc\n", COLOR_DIM, COLOR_RESET);
+    printf("  Dimmed indicators are stale or not yet checked against the remote\n");
     printf("\n");
 }
 
@@ -797,11 +3219,44 @@ static void print_version(void) {
     printf("%s  GitSync v2.0  %s\n", COLOR_GREEN, COLOR_RESET);
 }
 
+/*
+ * atexit() hook for GITSYNC_CPU_REPORT=FILE: append this process's own
+ * user and system CPU seconds, excluding git children, so benchmarks
+ * (scripts/pgo-workload.sh) measure gitsync's code rather than git's.
+ */
+static void report_cpu_time(void) {
+    const char* report_path = getenv("GITSYNC_CPU_REPORT");
+    struct rusage usage;
+    
+    if (!report_path || getrusage(RUSAGE_SELF, &usage) != 0) return;
+    FILE* fp = fopen(report_path, "a");
+    if (!fp) return;
+    fprintf(fp, "%ld.%06ld %ld.%06ld\n",
+            (long)usage.ru_utime.tv_sec, (long)usage.ru_utime.tv_usec,
+            (long)usage.ru_stime.tv_sec, (long)usage.ru_stime.tv_usec);
+    fclose(fp);
+}
+
 int main(int argc, char* argv[]) {
     ProgramConfig config;
     
     parse_arguments(argc, argv, &config);
     
+    if (config.fsmonitor_query) {
+        return run_fsmonitor_query(config.fsmonitor_version, config.fsmonitor_token);
+    }
+    
+    signal(SIGINT, handle_exit_signal);
+    signal(SIGTERM, handle_exit_signal);
+    signal(SIGHUP, handle_exit_signal);
+    if (getenv("GITSYNC_CPU_REPORT")) atexit(report_cpu_time);
+    
+    git_network_timeout = config.git_timeout;
+    if (config.log_dir) {
+        mkdir(config.log_dir, 0755);
+        snprintf(log_dir, sizeof(log_dir), "%s", config.log_dir);
+    }
+    
     if (config.show_version) {
         print_version();
         return 0;
@@ -830,6 +3285,40 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
+    if (gitsync_data_path(state_path, sizeof(state_path), "sync.state") != 0) {
+        show_warning("Data directory path is too long; sync results will not be kept");
+    }
+    state_load(0);
+    
+    if (config.watch_interval >= 0) {
+        run_watch(&config);
+        return 0;
+    }
+    
+    if (config.fsmonitor_install) {
+        return run_fsmonitor_install(config.fsmonitor_install > 0);
+    }
+    
+    if (config.clone_groups) {
+        return run_clone_groups(config.clone_groups == 2);
+    }
+    
+    if (config.sync_all) {
+        char journal_path[MAX_PATH_LEN];
+        if (!config.journal_path) {
+            if (gitsync_data_path(journal_path, sizeof(journal_path), "sync.journal") != 0) {
+                show_error("Data directory path is too long; pass --journal PATH");
+                return 1;
+            }
+            config.journal_path = journal_path;
+        }
+        int result = run_sync_all(&config);
+        if (config.metrics_file && write_metrics_file(config.metrics_file) != 0) {
+            show_warning("Could not write metrics file");
+        }
+        return result;
+    }
+    
     char* selected = select_repository_interface(config.mode, config.scan_dir, config.commit_mode);
     
     if (selected) {
@@ -843,5 +3332,9 @@ int main(int argc, char* argv[]) {
         show_info("No repository selected.");
     }
     
+    if (config.metrics_file && write_metrics_file(config.metrics_file) != 0) {
+        show_warning("Could not write metrics file");
+    }
+    
     return 0;
 }
\ No newline at end of file